@@ -0,0 +1,18 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+// Every texture of the scene, indexed with the per-draw index from the push constants
+layout(set = 1, binding = 0) uniform sampler2D textures[];
+
+layout(push_constant) uniform PushConstants {
+    layout(offset = 64) uint textureIndex;
+} pushConstants;
+
+layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec2 fragTexCoord;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    outColor = texture(textures[pushConstants.textureIndex], fragTexCoord);
+}
\ No newline at end of file
@@ -0,0 +1,182 @@
+#include "VulkanBarrierBatcher.h"
+
+#include "VulkanBuffer.h"
+#include "VulkanCommandBuffer.h"
+
+static const VkAccessFlags2 WriteAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT |
+                                              VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_2_TRANSFER_WRITE_BIT | VK_ACCESS_2_HOST_WRITE_BIT |
+                                              VK_ACCESS_2_MEMORY_WRITE_BIT;
+
+VulkanBarrierBatcher::VulkanBarrierBatcher(std::shared_ptr<VulkanCommandBuffer> commandBuffer_) : commandBuffer(commandBuffer_) {
+}
+
+void VulkanBarrierBatcher::Transition(std::shared_ptr<VulkanImage> image, VkImageLayout newLayout, VkPipelineStageFlags2 stages, VkAccessFlags2 accessMask,
+                                      uint32_t baseMipLevel, uint32_t levelCount, uint32_t baseArrayLayer, uint32_t layerCount) {
+    ForEachStateRun(image, baseMipLevel, levelCount, baseArrayLayer, layerCount,
+                    [&](uint32_t runBaseMipLevel, uint32_t runLevelCount, uint32_t arrayLayer, const VulkanImageState &state) {
+        bool isReadOnly = !IsWriteAccess(state.accessMask) && !IsWriteAccess(accessMask);
+        if (state.layout == newLayout && isReadOnly) {
+            // Nothing to do if an earlier barrier already made the data visible to these stages
+            if ((stages & ~state.stages) == 0 && (accessMask & ~state.accessMask) == 0)
+                return;
+
+            // Otherwise chain onto the earlier readers, which waited for the last write
+            AddImageBarrier(image, state, {newLayout, state.stages | stages, state.accessMask | accessMask}, runBaseMipLevel, runLevelCount, arrayLayer);
+            return;
+        }
+
+        AddImageBarrier(image, state, {newLayout, stages, accessMask}, runBaseMipLevel, runLevelCount, arrayLayer);
+    });
+}
+
+void VulkanBarrierBatcher::TransferOwnership(VulkanBarrierBatcher &acquireBarriers, std::shared_ptr<VulkanImage> image, uint32_t srcFamilyIndex,
+                                             uint32_t dstFamilyIndex, VkPipelineStageFlags2 stages, VkAccessFlags2 accessMask) {
+    ForEachStateRun(image, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS,
+                    [&](uint32_t baseMipLevel, uint32_t levelCount, uint32_t arrayLayer, const VulkanImageState &state) {
+        VulkanImageState released{state.layout, VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE};
+        VulkanImageState acquired{state.layout, stages, accessMask};
+
+        AddImageBarrier(image, state, released, baseMipLevel, levelCount, arrayLayer, srcFamilyIndex, dstFamilyIndex);
+        acquireBarriers.AddImageBarrier(image, released, acquired, baseMipLevel, levelCount, arrayLayer, srcFamilyIndex, dstFamilyIndex);
+    });
+}
+
+void VulkanBarrierBatcher::TransferOwnership(VulkanBarrierBatcher &acquireBarriers, std::shared_ptr<VulkanBuffer> buffer, VkDeviceSize offset, VkDeviceSize size,
+                                             uint32_t srcFamilyIndex, uint32_t dstFamilyIndex,
+                                             VkPipelineStageFlags2 srcStages, VkAccessFlags2 srcAccessMask,
+                                             VkPipelineStageFlags2 dstStages, VkAccessFlags2 dstAccessMask) {
+    VkBufferMemoryBarrier2 barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2;
+    barrier.srcQueueFamilyIndex = srcFamilyIndex;
+    barrier.dstQueueFamilyIndex = dstFamilyIndex;
+    barrier.buffer = buffer->Handle();
+    barrier.offset = offset;
+    barrier.size = size;
+
+    barrier.srcStageMask = srcStages;
+    barrier.srcAccessMask = srcAccessMask & WriteAccessMask;
+    barrier.dstStageMask = VK_PIPELINE_STAGE_2_NONE;
+    barrier.dstAccessMask = VK_ACCESS_2_NONE;
+    bufferBarriers.push_back(barrier);
+
+    barrier.srcStageMask = VK_PIPELINE_STAGE_2_NONE;
+    barrier.srcAccessMask = VK_ACCESS_2_NONE;
+    barrier.dstStageMask = dstStages;
+    barrier.dstAccessMask = dstAccessMask;
+    acquireBarriers.bufferBarriers.push_back(barrier);
+}
+
+void VulkanBarrierBatcher::MemoryBarrier(VkPipelineStageFlags2 srcStages, VkAccessFlags2 srcAccessMask,
+                                         VkPipelineStageFlags2 dstStages, VkAccessFlags2 dstAccessMask) {
+    VkMemoryBarrier2 barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+    barrier.srcStageMask = srcStages;
+    barrier.srcAccessMask = srcAccessMask & WriteAccessMask;
+    barrier.dstStageMask = dstStages;
+    barrier.dstAccessMask = dstAccessMask;
+    memoryBarriers.push_back(barrier);
+}
+
+bool VulkanBarrierBatcher::IsEmpty() const {
+    return memoryBarriers.empty() && bufferBarriers.empty() && imageBarriers.empty();
+}
+
+std::shared_ptr<VulkanCommandBuffer> VulkanBarrierBatcher::GetCommandBuffer() {
+    return commandBuffer;
+}
+
+void VulkanBarrierBatcher::Flush() {
+    if (IsEmpty())
+        return;
+
+    VkDependencyInfo dependencyInfo{};
+    dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+    dependencyInfo.memoryBarrierCount = static_cast<uint32_t>(memoryBarriers.size());
+    dependencyInfo.pMemoryBarriers = memoryBarriers.data();
+    dependencyInfo.bufferMemoryBarrierCount = static_cast<uint32_t>(bufferBarriers.size());
+    dependencyInfo.pBufferMemoryBarriers = bufferBarriers.data();
+    dependencyInfo.imageMemoryBarrierCount = static_cast<uint32_t>(imageBarriers.size());
+    dependencyInfo.pImageMemoryBarriers = imageBarriers.data();
+    vkCmdPipelineBarrier2(commandBuffer->Handle(), &dependencyInfo);
+
+    memoryBarriers.clear();
+    bufferBarriers.clear();
+    imageBarriers.clear();
+    pendingSubresources.clear();
+}
+
+bool VulkanBarrierBatcher::IsWriteAccess(VkAccessFlags2 accessMask) {
+    return (accessMask & WriteAccessMask) != 0;
+}
+
+void VulkanBarrierBatcher::ForEachStateRun(std::shared_ptr<VulkanImage> image, uint32_t baseMipLevel, uint32_t levelCount,
+                                           uint32_t baseArrayLayer, uint32_t layerCount, const RunCallback &callback) {
+    uint32_t mipEnd = levelCount == VK_REMAINING_MIP_LEVELS ? image->GetMipLevels() : baseMipLevel + levelCount;
+    uint32_t layerEnd = layerCount == VK_REMAINING_ARRAY_LAYERS ? image->GetArrayLayers() : baseArrayLayer + layerCount;
+    if (mipEnd > image->GetMipLevels() || layerEnd > image->GetArrayLayers()) {
+        throw std::out_of_range("image subresource range out of bounds!");
+    }
+
+    for (uint32_t layer = baseArrayLayer; layer < layerEnd; layer++) {
+        uint32_t mip = baseMipLevel;
+        while (mip < mipEnd) {
+            VulkanImageState state = image->GetSubresourceState(mip, layer);
+            uint32_t runEnd = mip + 1;
+            while (runEnd < mipEnd && image->GetSubresourceState(runEnd, layer) == state)
+                runEnd++;
+
+            callback(mip, runEnd - mip, layer, state);
+            mip = runEnd;
+        }
+    }
+}
+
+void VulkanBarrierBatcher::AddImageBarrier(std::shared_ptr<VulkanImage> image, const VulkanImageState &oldState, const VulkanImageState &newState,
+                                           uint32_t baseMipLevel, uint32_t levelCount, uint32_t arrayLayer,
+                                           uint32_t srcFamilyIndex, uint32_t dstFamilyIndex) {
+    // Barriers of one batch execute unordered, a subresource can only be transitioned once per flush
+    for (uint32_t mip = baseMipLevel; mip < baseMipLevel + levelCount; mip++) {
+        if (pendingSubresources.count({image->Handle(), mip, arrayLayer}) != 0) {
+            Flush();
+            break;
+        }
+    }
+
+    VkImageMemoryBarrier2 barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+    barrier.srcStageMask = oldState.stages;
+    barrier.srcAccessMask = oldState.accessMask & WriteAccessMask;
+    barrier.dstStageMask = newState.stages;
+    barrier.dstAccessMask = newState.accessMask;
+    barrier.oldLayout = oldState.layout;
+    barrier.newLayout = newState.layout;
+    barrier.srcQueueFamilyIndex = srcFamilyIndex;
+    barrier.dstQueueFamilyIndex = dstFamilyIndex;
+    barrier.image = image->Handle();
+    barrier.subresourceRange.aspectMask = image->GetAspectMask();
+    barrier.subresourceRange.baseMipLevel = baseMipLevel;
+    barrier.subresourceRange.levelCount = levelCount;
+    barrier.subresourceRange.baseArrayLayer = arrayLayer;
+    barrier.subresourceRange.layerCount = 1;
+
+    // Runs covering the same mip levels of neighbouring layers are merged into one barrier
+    bool isMerged = false;
+    if (!imageBarriers.empty()) {
+        auto &previous = imageBarriers.back();
+        isMerged = previous.image == barrier.image && previous.srcStageMask == barrier.srcStageMask && previous.srcAccessMask == barrier.srcAccessMask &&
+                   previous.dstStageMask == barrier.dstStageMask && previous.dstAccessMask == barrier.dstAccessMask &&
+                   previous.oldLayout == barrier.oldLayout && previous.newLayout == barrier.newLayout &&
+                   previous.srcQueueFamilyIndex == barrier.srcQueueFamilyIndex && previous.dstQueueFamilyIndex == barrier.dstQueueFamilyIndex &&
+                   previous.subresourceRange.baseMipLevel == baseMipLevel && previous.subresourceRange.levelCount == levelCount &&
+                   previous.subresourceRange.baseArrayLayer + previous.subresourceRange.layerCount == arrayLayer;
+        if (isMerged)
+            previous.subresourceRange.layerCount++;
+    }
+    if (!isMerged)
+        imageBarriers.push_back(barrier);
+
+    for (uint32_t mip = baseMipLevel; mip < baseMipLevel + levelCount; mip++) {
+        pendingSubresources.insert({image->Handle(), mip, arrayLayer});
+        image->SetSubresourceState(mip, arrayLayer, newState);
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <set>
+#include <tuple>
+#include <functional>
+
+#include "vk_common.h"
+#include "VulkanImage.h"
+
+// Collects the barriers of a command buffer and records them with a single vkCmdPipelineBarrier2 call.
+// Image transitions start from the per-subresource state tracked by VulkanImage, so callers only name
+// the layout and access they need next. Barriers between read-only accesses in the same layout are skipped.
+//
+// The tracked state follows recording order, so it is only valid for command buffers that are submitted
+// in the order they were recorded in.
+class VulkanBarrierBatcher {
+    VK_NON_COPIABLE(VulkanBarrierBatcher)
+
+public:
+    explicit VulkanBarrierBatcher(std::shared_ptr<VulkanCommandBuffer> commandBuffer_);
+
+    void Transition(std::shared_ptr<VulkanImage> image, VkImageLayout newLayout, VkPipelineStageFlags2 stages, VkAccessFlags2 accessMask,
+                    uint32_t baseMipLevel = 0, uint32_t levelCount = VK_REMAINING_MIP_LEVELS,
+                    uint32_t baseArrayLayer = 0, uint32_t layerCount = VK_REMAINING_ARRAY_LAYERS);
+
+    // Records the release half of a queue family ownership transfer into this batcher and the acquire half into the
+    // batcher of the destination queue. The layout is kept, the destination access becomes the tracked state.
+    void TransferOwnership(VulkanBarrierBatcher &acquireBarriers, std::shared_ptr<VulkanImage> image, uint32_t srcFamilyIndex, uint32_t dstFamilyIndex,
+                           VkPipelineStageFlags2 stages, VkAccessFlags2 accessMask);
+
+    void TransferOwnership(VulkanBarrierBatcher &acquireBarriers, std::shared_ptr<VulkanBuffer> buffer, VkDeviceSize offset, VkDeviceSize size,
+                           uint32_t srcFamilyIndex, uint32_t dstFamilyIndex,
+                           VkPipelineStageFlags2 srcStages, VkAccessFlags2 srcAccessMask, VkPipelineStageFlags2 dstStages, VkAccessFlags2 dstAccessMask);
+
+    void MemoryBarrier(VkPipelineStageFlags2 srcStages, VkAccessFlags2 srcAccessMask, VkPipelineStageFlags2 dstStages, VkAccessFlags2 dstAccessMask);
+
+    bool IsEmpty() const;
+
+    std::shared_ptr<VulkanCommandBuffer> GetCommandBuffer();
+
+    // Records every collected barrier, does nothing if there are none
+    void Flush();
+
+public:
+    static bool IsWriteAccess(VkAccessFlags2 accessMask);
+
+private:
+    using RunCallback = std::function<void(uint32_t baseMipLevel, uint32_t levelCount, uint32_t arrayLayer, const VulkanImageState &state)>;
+
+    // Splits the range into runs of consecutive mip levels that share the same tracked state
+    static void ForEachStateRun(std::shared_ptr<VulkanImage> image, uint32_t baseMipLevel, uint32_t levelCount,
+                                uint32_t baseArrayLayer, uint32_t layerCount, const RunCallback &callback);
+
+    void AddImageBarrier(std::shared_ptr<VulkanImage> image, const VulkanImageState &oldState, const VulkanImageState &newState,
+                         uint32_t baseMipLevel, uint32_t levelCount, uint32_t arrayLayer,
+                         uint32_t srcFamilyIndex = VK_QUEUE_FAMILY_IGNORED, uint32_t dstFamilyIndex = VK_QUEUE_FAMILY_IGNORED);
+
+private:
+    std::shared_ptr<VulkanCommandBuffer> commandBuffer;
+
+    std::vector<VkMemoryBarrier2> memoryBarriers;
+    std::vector<VkBufferMemoryBarrier2> bufferBarriers;
+    std::vector<VkImageMemoryBarrier2> imageBarriers;
+
+    // Subresources with a barrier in the batch, a second transition of one of them flushes the batch first
+    std::set<std::tuple<VkImage, uint32_t, uint32_t>> pendingSubresources;
+};
@@ -0,0 +1,163 @@
+#include "VulkanBindlessTextureTable.h"
+#include "VulkanDevice.h"
+#include "VulkanDescriptorSet.h"
+#include "VulkanDescriptorWriter.h"
+#include "VulkanDeletionQueue.h"
+#include "VulkanCommandBuffer.h"
+#include "VulkanGraphicsPipeline.h"
+
+#include <algorithm>
+
+VulkanBindlessTextureTable::VulkanBindlessTextureTable(std::shared_ptr<VulkanDevice> device_, uint32_t capacity_, VkShaderStageFlags stages_)
+    : device(device_), stages(stages_), releasedSlots(std::make_shared<SlotList>()) {
+    if (!device->IsBindlessSupported()) {
+        throw std::runtime_error("device does not support descriptor indexing for bindless textures!");
+    }
+
+    capacity = std::min(capacity_, device->GetMaxBindlessTextures());
+    entries.resize(capacity);
+    pendingWrites = std::make_shared<VulkanDescriptorWriter>(device);
+
+    // Descriptor Set Layout
+    VkDescriptorSetLayoutBinding layoutBinding{};
+    layoutBinding.binding = 0;
+    layoutBinding.descriptorCount = capacity;
+    layoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    layoutBinding.stageFlags = stages;
+
+    VkDescriptorBindingFlags bindingFlags = BindingFlags;
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+    bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+    bindingFlagsInfo.bindingCount = 1;
+    bindingFlagsInfo.pBindingFlags = &bindingFlags;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.pNext = &bindingFlagsInfo;
+    layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+    layoutInfo.bindingCount = 1;
+    layoutInfo.pBindings = &layoutBinding;
+
+    if (vkCreateDescriptorSetLayout(device->Handle(), &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create bindless descriptor set layout!");
+    }
+
+    // Descriptor Pool, update-after-bind sets can't come from the regular allocator pools
+    VkDescriptorPoolSize poolSize{};
+    poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    poolSize.descriptorCount = capacity;
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+    poolInfo.maxSets = 1;
+
+    if (vkCreateDescriptorPool(device->Handle(), &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create bindless descriptor pool!");
+    }
+
+    // Allocate Set
+    VkDescriptorSetVariableDescriptorCountAllocateInfo variableCountInfo{};
+    variableCountInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO;
+    variableCountInfo.descriptorSetCount = 1;
+    variableCountInfo.pDescriptorCounts = &capacity;
+
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.pNext = &variableCountInfo;
+    allocInfo.descriptorPool = descriptorPool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &descriptorSetLayout;
+
+    VkDescriptorSet descriptorSetHandle;
+    if (vkAllocateDescriptorSets(device->Handle(), &allocInfo, &descriptorSetHandle) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate bindless descriptor set!");
+    }
+    descriptorSet = std::make_shared<VulkanDescriptorSet>(device, descriptorSetHandle);
+}
+
+VulkanBindlessTextureTable::~VulkanBindlessTextureTable() {
+    // The registered views stay alive until the set can no longer be in use
+    VkDevice deviceHandle = device->Handle();
+    device->GetDeletionQueue()->Enqueue([deviceHandle, descriptorSetLayout = descriptorSetLayout, descriptorPool = descriptorPool,
+                                         entries = std::move(entries)]() mutable {
+        VkDestroy(vkDestroyDescriptorPool, deviceHandle, descriptorPool);
+        VkDestroy(vkDestroyDescriptorSetLayout, deviceHandle, descriptorSetLayout);
+    });
+}
+
+uint32_t VulkanBindlessTextureTable::Register(std::shared_ptr<VulkanTextureSampler> textureSampler, std::shared_ptr<VulkanImageView> imageView) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    uint32_t index;
+    {
+        std::lock_guard<std::mutex> slotLock(releasedSlots->mutex);
+        if (!releasedSlots->freeSlots.empty()) {
+            index = releasedSlots->freeSlots.back();
+            releasedSlots->freeSlots.pop_back();
+        } else if (nextSlot < capacity) {
+            index = nextSlot++;
+        } else {
+            throw std::runtime_error("bindless texture table is full!");
+        }
+    }
+
+    entries[index] = {textureSampler, imageView};
+    pendingWrites->WriteImage(descriptorSet, 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, textureSampler, imageView,
+                              VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, index);
+
+    return index;
+}
+
+void VulkanBindlessTextureTable::Release(uint32_t index) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (index >= nextSlot || entries[index].imageView == nullptr) {
+        throw std::out_of_range("bindless texture slot is not registered!");
+    }
+
+    // Shaders may still sample the slot in frames in flight, the descriptor is left as is until then
+    device->GetDeletionQueue()->Enqueue([slots = releasedSlots, index, entry = std::move(entries[index])]() {
+        std::lock_guard<std::mutex> slotLock(slots->mutex);
+        slots->freeSlots.push_back(index);
+    });
+    entries[index] = {};
+}
+
+uint32_t VulkanBindlessTextureTable::GetCapacity() const {
+    return capacity;
+}
+
+VkDescriptorSetLayout VulkanBindlessTextureTable::GetLayout() {
+    return descriptorSetLayout;
+}
+
+VulkanDescriptorSetLayoutDescription VulkanBindlessTextureTable::GetLayoutDescription() {
+    VkDescriptorSetLayoutBinding layoutBinding{};
+    layoutBinding.binding = 0;
+    layoutBinding.descriptorCount = capacity;
+    layoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    layoutBinding.stageFlags = stages;
+
+    VulkanDescriptorSetLayoutDescription description;
+    description.layout = descriptorSetLayout;
+    description.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+    description.bindings = {layoutBinding};
+    description.bindingFlags = {BindingFlags};
+    return description;
+}
+
+void VulkanBindlessTextureTable::Flush() {
+    std::lock_guard<std::mutex> lock(mutex);
+    pendingWrites->Flush();
+}
+
+void VulkanBindlessTextureTable::Bind(std::shared_ptr<VulkanCommandBuffer> commandBuffer, std::shared_ptr<VulkanGraphicsPipeline> pipeline,
+                                      uint32_t setIndex) {
+    Flush();
+
+    descriptorSet->Bind(commandBuffer, pipeline, {}, setIndex);
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <mutex>
+
+#include "vk_common.h"
+
+// One large array of combined image samplers that shaders index by integer, so every texture of a scene is
+// reachable through a single descriptor set bind. The binding is partially bound and update-after-bind: slots
+// can be filled while command buffers that use the set are recorded or pending, as long as those command
+// buffers don't access the slots being changed. Needs VulkanDevice::IsBindlessSupported.
+class VulkanBindlessTextureTable {
+    VK_NON_COPIABLE(VulkanBindlessTextureTable)
+
+public:
+    VulkanBindlessTextureTable(std::shared_ptr<VulkanDevice> device_, uint32_t capacity_ = 4096,
+                               VkShaderStageFlags stages_ = VK_SHADER_STAGE_FRAGMENT_BIT);
+
+    ~VulkanBindlessTextureTable();
+
+    // Returns the array index the shaders use for the texture, the view and sampler are kept alive until released
+    uint32_t Register(std::shared_ptr<VulkanTextureSampler> textureSampler, std::shared_ptr<VulkanImageView> imageView);
+
+    // The slot is only reused once the GPU is done with everything submitted so far
+    void Release(uint32_t index);
+
+    uint32_t GetCapacity() const;
+
+    VkDescriptorSetLayout GetLayout();
+
+    // The layout with the binding it was created from, for pipeline states
+    VulkanDescriptorSetLayoutDescription GetLayoutDescription();
+
+    // Applies the pending registrations, Bind does it as well
+    void Flush();
+
+    void Bind(std::shared_ptr<VulkanCommandBuffer> commandBuffer, std::shared_ptr<VulkanGraphicsPipeline> pipeline, uint32_t setIndex);
+
+private:
+    struct Entry {
+        std::shared_ptr<VulkanTextureSampler> textureSampler;
+        std::shared_ptr<VulkanImageView> imageView;
+    };
+
+    // Shared with the deferred releases, which may run after the table is gone
+    struct SlotList {
+        std::mutex mutex;
+        std::vector<uint32_t> freeSlots;
+    };
+
+    static constexpr VkDescriptorBindingFlags BindingFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+                                                           VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT |
+                                                           VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT;
+
+    std::shared_ptr<VulkanDevice> device;
+    uint32_t capacity;
+    VkShaderStageFlags stages;
+
+    std::mutex mutex;
+    std::vector<Entry> entries;
+    uint32_t nextSlot = 0;
+    std::shared_ptr<SlotList> releasedSlots;
+    std::shared_ptr<VulkanDescriptorWriter> pendingWrites;
+
+    VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+    VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+    std::shared_ptr<VulkanDescriptorSet> descriptorSet;
+};
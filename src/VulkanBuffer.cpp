@@ -4,9 +4,12 @@
 #include "VulkanImage.h"
 #include "VulkanCommandPool.h"
 #include "VulkanCommandBuffer.h"
+#include "VulkanDeletionQueue.h"
+
+#include <algorithm>
 
 VulkanBuffer::VulkanBuffer(std::shared_ptr<VulkanDevice> device_, std::shared_ptr<VulkanInstance> instance_,
-                           VkDeviceSize size_, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties)
+                           VkDeviceSize size_, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkMemoryPropertyFlags preferredProperties)
     : device(device_), instance(instance_), size(size_) {
     VkBufferCreateInfo bufferInfo{};
     bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -21,54 +24,198 @@ VulkanBuffer::VulkanBuffer(std::shared_ptr<VulkanDevice> device_, std::shared_pt
     VkMemoryRequirements memRequirements;
     vkGetBufferMemoryRequirements(device->Handle(), buffer, &memRequirements);
 
-    VkMemoryAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = VulkanImage::FindMemoryType(instance, memRequirements.memoryTypeBits, properties);
-
-    if (vkAllocateMemory(device->Handle(), &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
-        throw std::runtime_error("failed to allocate buffer memory!");
-    }
+    // Host visible buffers that are only ever copied from are staging memory
+    VulkanMemoryCategory category = (usage == VK_BUFFER_USAGE_TRANSFER_SRC_BIT && (properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT))
+                                    ? VulkanMemoryCategory::Staging : VulkanMemoryCategory::Buffer;
+    allocation = device->GetMemoryAllocator()->Allocate(memRequirements, properties, preferredProperties, true, category);
 
-    vkBindBufferMemory(device->Handle(), buffer, bufferMemory, 0);
+    vkBindBufferMemory(device->Handle(), buffer, allocation.memory, allocation.offset);
 }
 
 VkDeviceMemory VulkanBuffer::GetMemory() {
-    return bufferMemory;
+    return allocation.memory;
+}
+
+void *VulkanBuffer::GetMappedData() {
+    return allocation.mappedData;
 }
 
 VulkanBuffer::~VulkanBuffer() {
-    vkDestroyBuffer(device->Handle(), buffer, nullptr);
-    vkFreeMemory(device->Handle(), bufferMemory, nullptr);
+    VkDevice deviceHandle = device->Handle();
+    auto memoryAllocator = device->GetMemoryAllocator();
+    device->GetDeletionQueue()->Enqueue([deviceHandle, memoryAllocator, buffer = buffer, allocation = allocation]() mutable {
+        VkDestroy(vkDestroyBuffer, deviceHandle, buffer);
+        memoryAllocator->Free(allocation);
+    });
 }
 
 void VulkanBuffer::CopyTo(std::shared_ptr<VulkanCommandPool> commandPool, std::shared_ptr<VulkanBuffer> destination, VkDeviceSize size_) {
     auto commandBuffer = commandPool->AllocateBuffer()->Begin(true);
+    CopyTo(commandBuffer, destination, size_);
+    commandBuffer->EndAndSubmit();
+}
 
+void VulkanBuffer::CopyTo(std::shared_ptr<VulkanCommandBuffer> commandBuffer, std::shared_ptr<VulkanBuffer> destination, VkDeviceSize size_,
+                          VkDeviceSize sourceOffset, VkDeviceSize destinationOffset) {
     VkBufferCopy copyRegion{};
+    copyRegion.srcOffset = sourceOffset;
+    copyRegion.dstOffset = destinationOffset;
     copyRegion.size = size_;
     vkCmdCopyBuffer(commandBuffer->Handle(), Handle(), destination->Handle(), 1, &copyRegion);
-
-    commandBuffer->EndAndSubmit();
 }
 
 void VulkanBuffer::CopyFrom(void *inputData, int length) {
-    void *data;
-    vkMapMemory(device->Handle(), bufferMemory, 0, length, 0, &data);
-    memcpy(data, inputData, length);
-    vkUnmapMemory(device->Handle(), bufferMemory);
+    Write(inputData, length);
+    Flush();
 
     size = length; // TODO Is this necessary? When does length differ from the stored size?
 }
 
+void VulkanBuffer::Write(const void *data, VkDeviceSize length, VkDeviceSize offset) {
+    if (allocation.mappedData == nullptr) {
+        throw std::runtime_error("buffer memory is not host visible!");
+    }
+    if (offset + length > size) {
+        throw std::runtime_error("buffer write is out of range!");
+    }
+
+    // Host visible memory is persistently mapped by the allocator
+    memcpy(static_cast<char *>(allocation.mappedData) + offset, data, length);
+    MarkDirty(offset, length);
+}
+
+void VulkanBuffer::Read(void *data, VkDeviceSize length, VkDeviceSize offset) {
+    if (allocation.mappedData == nullptr) {
+        throw std::runtime_error("buffer memory is not host visible!");
+    }
+    if (offset + length > size) {
+        throw std::runtime_error("buffer read is out of range!");
+    }
+
+    memcpy(data, static_cast<char *>(allocation.mappedData) + offset, length);
+}
+
+void VulkanBuffer::MarkDirty(VkDeviceSize offset, VkDeviceSize length) {
+    if (IsHostCoherent() || length == 0)
+        return;
+
+    if (dirtyBegin >= dirtyEnd) {
+        dirtyBegin = offset;
+        dirtyEnd = offset + length;
+    } else {
+        dirtyBegin = std::min(dirtyBegin, offset);
+        dirtyEnd = std::max(dirtyEnd, offset + length);
+    }
+}
+
+void VulkanBuffer::Flush() {
+    if (dirtyBegin >= dirtyEnd)
+        return;
+
+    Flush(dirtyBegin, dirtyEnd - dirtyBegin);
+}
+
+void VulkanBuffer::Flush(VkDeviceSize offset, VkDeviceSize length) {
+    if (IsHostCoherent())
+        return;
+
+    if (length == VK_WHOLE_SIZE)
+        length = size - offset;
+
+    VkMappedMemoryRange range = GetMappedRange(offset, length);
+    if (vkFlushMappedMemoryRanges(device->Handle(), 1, &range) != VK_SUCCESS) {
+        throw std::runtime_error("failed to flush mapped memory range!");
+    }
+
+    // Only drop the part of the dirty range that was flushed, a flush in the middle keeps the whole range pending
+    VkDeviceSize flushEnd = offset + length;
+    if (offset <= dirtyBegin && flushEnd >= dirtyEnd) {
+        dirtyBegin = dirtyEnd = 0;
+    } else if (offset <= dirtyBegin && flushEnd > dirtyBegin) {
+        dirtyBegin = flushEnd;
+    } else if (flushEnd >= dirtyEnd && offset < dirtyEnd) {
+        dirtyEnd = offset;
+    }
+}
+
+void VulkanBuffer::Invalidate(VkDeviceSize offset, VkDeviceSize length) {
+    if (IsHostCoherent())
+        return;
+
+    if (length == VK_WHOLE_SIZE)
+        length = size - offset;
+
+    VkMappedMemoryRange range = GetMappedRange(offset, length);
+    if (vkInvalidateMappedMemoryRanges(device->Handle(), 1, &range) != VK_SUCCESS) {
+        throw std::runtime_error("failed to invalidate mapped memory range!");
+    }
+}
+
+bool VulkanBuffer::IsHostCoherent() const {
+    return (allocation.propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+}
+
+void VulkanBuffer::FlushAll(std::shared_ptr<VulkanDevice> device, const std::vector<std::shared_ptr<VulkanBuffer>> &buffers) {
+    std::vector<VkMappedMemoryRange> ranges;
+    for (const auto &buffer: buffers) {
+        if (buffer->IsHostCoherent() || buffer->dirtyBegin >= buffer->dirtyEnd)
+            continue;
+
+        ranges.push_back(buffer->GetMappedRange(buffer->dirtyBegin, buffer->dirtyEnd - buffer->dirtyBegin));
+        buffer->dirtyBegin = buffer->dirtyEnd = 0;
+    }
+
+    if (ranges.empty())
+        return;
+
+    if (vkFlushMappedMemoryRanges(device->Handle(), static_cast<uint32_t>(ranges.size()), ranges.data()) != VK_SUCCESS) {
+        throw std::runtime_error("failed to flush mapped memory ranges!");
+    }
+}
+
+void VulkanBuffer::InvalidateAll(std::shared_ptr<VulkanDevice> device, const std::vector<std::shared_ptr<VulkanBuffer>> &buffers) {
+    std::vector<VkMappedMemoryRange> ranges;
+    for (const auto &buffer: buffers) {
+        if (!buffer->IsHostCoherent())
+            ranges.push_back(buffer->GetMappedRange(0, buffer->size));
+    }
+
+    if (ranges.empty())
+        return;
+
+    if (vkInvalidateMappedMemoryRanges(device->Handle(), static_cast<uint32_t>(ranges.size()), ranges.data()) != VK_SUCCESS) {
+        throw std::runtime_error("failed to invalidate mapped memory ranges!");
+    }
+}
+
+VkMappedMemoryRange VulkanBuffer::GetMappedRange(VkDeviceSize offset, VkDeviceSize length) const {
+    // Ranges have to be aligned to nonCoherentAtomSize, or reach the end of the memory object
+    VkDeviceSize atomSize = device->GetMemoryAllocator()->GetNonCoherentAtomSize();
+    VkDeviceSize begin = allocation.offset + offset;
+    VkDeviceSize end = allocation.offset + offset + length;
+    begin -= begin % atomSize;
+    end = std::min((end + atomSize - 1) / atomSize * atomSize, allocation.memorySize);
+
+    VkMappedMemoryRange range{};
+    range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+    range.memory = allocation.memory;
+    range.offset = begin;
+    range.size = end - begin;
+    return range;
+}
+
 void VulkanBuffer::CopyTo(std::shared_ptr<VulkanCommandPool> commandPool, std::shared_ptr<VulkanImage> destination) {
     auto commandBuffer = commandPool->AllocateBuffer()->Begin(true);
+    CopyTo(commandBuffer, destination);
+    commandBuffer->EndAndSubmit();
+}
 
+void VulkanBuffer::CopyTo(std::shared_ptr<VulkanCommandBuffer> commandBuffer, std::shared_ptr<VulkanImage> destination, VkDeviceSize sourceOffset) {
     uint32_t width, height;
     destination->GetSize(width, height);
 
     VkBufferImageCopy region{};
-    region.bufferOffset = 0;
+    region.bufferOffset = sourceOffset;
     region.bufferRowLength = 0;
     region.bufferImageHeight = 0;
     region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
@@ -83,8 +230,6 @@ void VulkanBuffer::CopyTo(std::shared_ptr<VulkanCommandPool> commandPool, std::s
     };
 
     vkCmdCopyBufferToImage(commandBuffer->Handle(), buffer, destination->Handle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-
-    commandBuffer->EndAndSubmit();
 }
 
 int VulkanBuffer::GetSize() const {
@@ -1,18 +1,56 @@
 #pragma once
 
+#include <span>
+
 #include "vk_common.h"
+#include "VulkanMemoryAllocator.h"
 
 class VulkanBuffer {
     VK_NON_COPIABLE(VulkanBuffer)
 
 public:
-    VulkanBuffer(std::shared_ptr<VulkanDevice> device_, std::shared_ptr<VulkanInstance> instance_, VkDeviceSize size_, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties);
+    VulkanBuffer(std::shared_ptr<VulkanDevice> device_, std::shared_ptr<VulkanInstance> instance_, VkDeviceSize size_, VkBufferUsageFlags usage,
+                 VkMemoryPropertyFlags properties, VkMemoryPropertyFlags preferredProperties = 0);
     ~VulkanBuffer();
 
     VkDeviceMemory GetMemory();
 
+    void *GetMappedData();
+
+    // Typed view into the persistent mapping. Host writes through the span have to be
+    // published with MarkDirty() + Flush() on memory that is not host coherent.
+    template<class T>
+    std::span<T> GetMappedSpan(VkDeviceSize offset = 0, size_t count = std::dynamic_extent) {
+        if (allocation.mappedData == nullptr) {
+            throw std::runtime_error("buffer memory is not host visible!");
+        }
+        if (count == std::dynamic_extent)
+            count = static_cast<size_t>((size - offset) / sizeof(T));
+        if (offset + count * sizeof(T) > size) {
+            throw std::runtime_error("mapped span is out of the buffer's range!");
+        }
+        return std::span<T>(reinterpret_cast<T *>(static_cast<char *>(allocation.mappedData) + offset), count);
+    }
+
+    void Write(const void *data, VkDeviceSize length, VkDeviceSize offset = 0);
+    void Read(void *data, VkDeviceSize length, VkDeviceSize offset = 0);
+
+    void MarkDirty(VkDeviceSize offset, VkDeviceSize length);
+    void Flush();
+    void Flush(VkDeviceSize offset, VkDeviceSize length);
+    void Invalidate(VkDeviceSize offset = 0, VkDeviceSize length = VK_WHOLE_SIZE);
+
+    bool IsHostCoherent() const;
+
+    // Flush or invalidate the pending ranges of several buffers with a single Vulkan call
+    static void FlushAll(std::shared_ptr<VulkanDevice> device, const std::vector<std::shared_ptr<VulkanBuffer>> &buffers);
+    static void InvalidateAll(std::shared_ptr<VulkanDevice> device, const std::vector<std::shared_ptr<VulkanBuffer>> &buffers);
+
     void CopyTo(std::shared_ptr<VulkanCommandPool> commandPool, std::shared_ptr<VulkanBuffer> destination, VkDeviceSize size);
     void CopyTo(std::shared_ptr<VulkanCommandPool> commandPool, std::shared_ptr<VulkanImage> destination);
+    void CopyTo(std::shared_ptr<VulkanCommandBuffer> commandBuffer, std::shared_ptr<VulkanBuffer> destination, VkDeviceSize size,
+                VkDeviceSize sourceOffset = 0, VkDeviceSize destinationOffset = 0);
+    void CopyTo(std::shared_ptr<VulkanCommandBuffer> commandBuffer, std::shared_ptr<VulkanImage> destination, VkDeviceSize sourceOffset = 0);
     void CopyFrom(void* data, int length);
 
     int GetSize() const;
@@ -22,7 +60,14 @@ private:
     std::shared_ptr<VulkanInstance> instance;
 
 private:
-    VkDeviceMemory bufferMemory;
+    VkMappedMemoryRange GetMappedRange(VkDeviceSize offset, VkDeviceSize length) const;
+
+private:
+    VulkanMemoryAllocation allocation;
     VkDeviceSize size;
+
+    // Range written since the last Flush(), empty when dirtyBegin >= dirtyEnd
+    VkDeviceSize dirtyBegin = 0;
+    VkDeviceSize dirtyEnd = 0;
 VK_HANDLE(VkBuffer, buffer);
 };
@@ -1,8 +1,14 @@
 #include "VulkanCommandBuffer.h"
 #include "VulkanDevice.h"
+#include "VulkanRenderPass.h"
+#include "VulkanFramebuffer.h"
+#include "VulkanGraphicsPipeline.h"
+#include "VulkanScheduler.h"
+#include "VulkanDeletionQueue.h"
 
-VulkanCommandBuffer::VulkanCommandBuffer(VkCommandBuffer commandBuffer_, std::shared_ptr<VulkanDevice> device_, std::shared_ptr<VulkanCommandPool> commandPool_)
-    : commandBuffer(commandBuffer_), device(device_), commandPool(commandPool_) {
+VulkanCommandBuffer::VulkanCommandBuffer(VkCommandBuffer commandBuffer_, std::shared_ptr<VulkanDevice> device_, std::shared_ptr<VulkanCommandPool> commandPool_,
+                                         VkCommandBufferLevel level_)
+    : commandBuffer(commandBuffer_), device(device_), commandPool(commandPool_), level(level_) {
 }
 
 std::shared_ptr<VulkanCommandBuffer> VulkanCommandBuffer::Begin(bool singleTime) {
@@ -14,10 +20,99 @@ std::shared_ptr<VulkanCommandBuffer> VulkanCommandBuffer::Begin(bool singleTime)
         beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
     vkBeginCommandBuffer(commandBuffer, &beginInfo);
     currentState = VulkanCommandBufferState::Recording;
+    boundDescriptorSets.clear();
 
     return this->shared_from_this();
 }
 
+std::shared_ptr<VulkanCommandBuffer> VulkanCommandBuffer::BeginSecondary(std::shared_ptr<VulkanRenderPass> renderPass, std::shared_ptr<VulkanFramebuffer> framebuffer,
+                                                                         uint32_t subpass) {
+    if (level != VK_COMMAND_BUFFER_LEVEL_SECONDARY) {
+        throw std::runtime_error("only secondary command buffers can inherit a render pass!");
+    }
+    isSingleTime = true;
+
+    VkCommandBufferInheritanceInfo inheritanceInfo{};
+    inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritanceInfo.renderPass = renderPass->Handle();
+    inheritanceInfo.subpass = subpass;
+    inheritanceInfo.framebuffer = framebuffer->Handle();
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    beginInfo.pInheritanceInfo = &inheritanceInfo;
+    vkBeginCommandBuffer(commandBuffer, &beginInfo);
+    currentState = VulkanCommandBufferState::Recording;
+    boundDescriptorSets.clear();
+
+    return this->shared_from_this();
+}
+
+void VulkanCommandBuffer::ExecuteCommands(const std::vector<std::shared_ptr<VulkanCommandBuffer>> &secondaryCommandBuffers) {
+    if (secondaryCommandBuffers.empty())
+        return;
+
+    std::vector<VkCommandBuffer> handles;
+    handles.reserve(secondaryCommandBuffers.size());
+    for (const auto &secondaryCommandBuffer: secondaryCommandBuffers)
+        handles.push_back(secondaryCommandBuffer->Handle());
+
+    vkCmdExecuteCommands(commandBuffer, static_cast<uint32_t>(handles.size()), handles.data());
+
+    // The bound state is undefined after executing secondary command buffers
+    boundDescriptorSets.clear();
+}
+
+void VulkanCommandBuffer::SetViewportAndScissor(VkExtent2D extent) {
+    VkViewport viewport{};
+    viewport.x = 0.0f;
+    viewport.y = 0.0f;
+    viewport.width = (float) extent.width;
+    viewport.height = (float) extent.height;
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+    vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+    VkRect2D scissor{};
+    scissor.offset = {0, 0};
+    scissor.extent = extent;
+    vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+}
+
+void VulkanCommandBuffer::PushConstants(std::shared_ptr<VulkanGraphicsPipeline> pipeline, uint32_t offset, uint32_t size, const void *data) {
+    VkShaderStageFlags stages = pipeline->GetPushConstantStages(offset, size);
+    if (stages == 0) {
+        throw std::runtime_error("pipeline has no push constant range for the pushed data!");
+    }
+
+    vkCmdPushConstants(commandBuffer, pipeline->GetPipelineLayout(), stages, offset, size, data);
+}
+
+void VulkanCommandBuffer::BindDescriptorSet(VkPipelineLayout pipelineLayout, uint32_t setIndex, VkDescriptorSet descriptorSet,
+                                            const std::vector<uint32_t> &dynamicOffsets) {
+    if (setIndex >= boundDescriptorSets.size())
+        boundDescriptorSets.resize(setIndex + 1);
+
+    auto &bound = boundDescriptorSets[setIndex];
+    if (bound.pipelineLayout == pipelineLayout && bound.descriptorSet == descriptorSet && bound.dynamicOffsets == dynamicOffsets)
+        return;
+
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, setIndex, 1, &descriptorSet,
+                            static_cast<uint32_t>(dynamicOffsets.size()), dynamicOffsets.data());
+    bound = {pipelineLayout, descriptorSet, dynamicOffsets};
+
+    // Binding with another layout may disturb the sets at the other indices, lower ones included, so they are bound again
+    for (uint32_t i = 0; i < boundDescriptorSets.size(); i++) {
+        if (i != setIndex && boundDescriptorSets[i].pipelineLayout != pipelineLayout)
+            boundDescriptorSets[i] = {};
+    }
+}
+
+VkCommandBufferLevel VulkanCommandBuffer::GetLevel() const {
+    return level;
+}
+
 void VulkanCommandBuffer::End() {
     vkEndCommandBuffer(commandBuffer);
     currentState = VulkanCommandBufferState::Executable;
@@ -26,13 +121,12 @@ void VulkanCommandBuffer::End() {
 void VulkanCommandBuffer::EndAndSubmit() {
     End();
 
-    VkSubmitInfo submitInfo{};
-    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &commandBuffer;
+    // Only wait for this submission instead of draining the whole queue
+    VulkanSubmission submission{};
+    submission.commandBuffers = {this->shared_from_this()};
 
-    vkQueueSubmit(device->GetGraphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE);
-    vkQueueWaitIdle(device->GetGraphicsQueue());
+    auto scheduler = device->GetScheduler();
+    scheduler->Wait(scheduler->Submit(QueueFamily::Graphics, submission));
     currentState = VulkanCommandBufferState::Pending;
 
     if (!isFreed) {
@@ -42,10 +136,15 @@ void VulkanCommandBuffer::EndAndSubmit() {
 }
 
 VulkanCommandBuffer::~VulkanCommandBuffer() {
-    if (!isFreed) {
-        vkFreeCommandBuffers(device->Handle(), commandPool->Handle(), 1, &commandBuffer);
-        isFreed = true;
-    }
+    if (isFreed)
+        return;
+
+    // The pool is destroyed through the same queue after this, so only its handle is captured
+    VkDevice deviceHandle = device->Handle();
+    device->GetDeletionQueue()->Enqueue([deviceHandle, commandPoolHandle = commandPool->Handle(), commandBuffer = commandBuffer]() {
+        vkFreeCommandBuffers(deviceHandle, commandPoolHandle, 1, &commandBuffer);
+    });
+    isFreed = true;
 }
 
 void VulkanCommandBuffer::Reset() {
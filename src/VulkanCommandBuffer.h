@@ -1,5 +1,7 @@
 #pragma once
 
+#include <type_traits>
+
 #include "vk_common.h"
 
 #include "VulkanCommandPool.h"
@@ -16,12 +18,37 @@ class VulkanCommandBuffer : public std::enable_shared_from_this<VulkanCommandBuf
     VK_NON_COPIABLE(VulkanCommandBuffer)
 
 public:
-    VulkanCommandBuffer(VkCommandBuffer commandBuffer_, std::shared_ptr<VulkanDevice> device_, std::shared_ptr<VulkanCommandPool> commandPool_);
+    VulkanCommandBuffer(VkCommandBuffer commandBuffer_, std::shared_ptr<VulkanDevice> device_, std::shared_ptr<VulkanCommandPool> commandPool_,
+                        VkCommandBufferLevel level_ = VK_COMMAND_BUFFER_LEVEL_PRIMARY);
 
     ~VulkanCommandBuffer();
 
     std::shared_ptr<VulkanCommandBuffer> Begin(bool singleTime);
 
+    // Begins a secondary command buffer that continues the given render pass instance
+    std::shared_ptr<VulkanCommandBuffer> BeginSecondary(std::shared_ptr<VulkanRenderPass> renderPass, std::shared_ptr<VulkanFramebuffer> framebuffer,
+                                                        uint32_t subpass = 0);
+
+    void ExecuteCommands(const std::vector<std::shared_ptr<VulkanCommandBuffer>> &secondaryCommandBuffers);
+
+    VkCommandBufferLevel GetLevel() const;
+
+    // Sets the dynamic viewport and scissor to cover the whole extent
+    void SetViewportAndScissor(VkExtent2D extent);
+
+    // Pushes small per-draw data without touching descriptor sets, the stages are taken from the push constant ranges of the pipeline
+    template<typename T>
+    void PushConstants(std::shared_ptr<VulkanGraphicsPipeline> pipeline, const T &data, uint32_t offset = 0) {
+        static_assert(std::is_trivially_copyable<T>::value, "push constant data has to be trivially copyable");
+        PushConstants(pipeline, offset, sizeof(T), &data);
+    }
+
+    void PushConstants(std::shared_ptr<VulkanGraphicsPipeline> pipeline, uint32_t offset, uint32_t size, const void *data);
+
+    // Skips the bind when the same set with the same dynamic offsets is already bound at this index for the same layout
+    void BindDescriptorSet(VkPipelineLayout pipelineLayout, uint32_t setIndex, VkDescriptorSet descriptorSet,
+                           const std::vector<uint32_t> &dynamicOffsets = {});
+
     void End();
 
     void EndAndSubmit();
@@ -34,6 +61,14 @@ private:
     std::shared_ptr<VulkanDevice> device;
     std::shared_ptr<VulkanCommandPool> commandPool;
 
+    struct BoundDescriptorSet {
+        VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+        VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+        std::vector<uint32_t> dynamicOffsets;
+    };
+    std::vector<BoundDescriptorSet> boundDescriptorSets; // Indexed by set index, cleared whenever the bound state is lost
+
+    VkCommandBufferLevel level;
     bool isSingleTime = false;
     bool isFreed = false;
 VK_HANDLE(VkCommandBuffer, commandBuffer)
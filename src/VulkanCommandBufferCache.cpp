@@ -0,0 +1,32 @@
+#include "VulkanCommandBufferCache.h"
+#include "VulkanCommandPool.h"
+#include "VulkanCommandBuffer.h"
+
+VulkanCommandBufferCache::VulkanCommandBufferCache(std::shared_ptr<VulkanCommandPool> commandPool_) : commandPool(commandPool_) {
+}
+
+std::shared_ptr<VulkanCommandBuffer> VulkanCommandBufferCache::GetOrRecord(uint32_t frameIndex, uint32_t imageIndex, uint64_t stateKey,
+                                                                          const RecordCallback &recordCallback) {
+    Entry &entry = entries[(static_cast<uint64_t>(frameIndex) << 32) | imageIndex];
+    if (entry.commandBuffer != nullptr && entry.version == version && entry.stateKey == stateKey)
+        return entry.commandBuffer;
+
+    if (entry.commandBuffer == nullptr)
+        entry.commandBuffer = commandPool->AllocateBuffer();
+    else
+        entry.commandBuffer->Reset();
+
+    // Not a one time submit, the buffer is resubmitted until it gets invalidated
+    entry.commandBuffer->Begin(false);
+    recordCallback(entry.commandBuffer);
+    entry.commandBuffer->End();
+
+    entry.stateKey = stateKey;
+    entry.version = version;
+
+    return entry.commandBuffer;
+}
+
+void VulkanCommandBufferCache::Invalidate() {
+    version++;
+}
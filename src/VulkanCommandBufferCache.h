@@ -0,0 +1,37 @@
+#pragma once
+
+#include <functional>
+#include <unordered_map>
+
+#include "vk_common.h"
+
+// Keeps pre-recorded primary command buffers for static content, one per (frame in flight, swap chain image)
+// pair. A buffer is only re-recorded after Invalidate() or when the state key it was recorded with changes,
+// so a static scene costs nothing but the submission. Since every entry belongs to a single frame in flight,
+// an entry is never pending when it is handed out again, as long as that frame's fence has been waited on.
+class VulkanCommandBufferCache {
+    VK_NON_COPIABLE(VulkanCommandBufferCache)
+
+public:
+    // Records into an already begun command buffer
+    using RecordCallback = std::function<void(std::shared_ptr<VulkanCommandBuffer> commandBuffer)>;
+
+    VulkanCommandBufferCache(std::shared_ptr<VulkanCommandPool> commandPool_);
+
+    // stateKey identifies any value baked into the recording that may change between frames (e.g. dynamic offsets)
+    std::shared_ptr<VulkanCommandBuffer> GetOrRecord(uint32_t frameIndex, uint32_t imageIndex, uint64_t stateKey, const RecordCallback &recordCallback);
+
+    // Call when the scene, pipeline or framebuffers change
+    void Invalidate();
+
+private:
+    struct Entry {
+        std::shared_ptr<VulkanCommandBuffer> commandBuffer;
+        uint64_t stateKey = 0;
+        uint64_t version = 0;
+    };
+
+    std::shared_ptr<VulkanCommandPool> commandPool;
+    std::unordered_map<uint64_t, Entry> entries;
+    uint64_t version = 1;
+};
@@ -2,13 +2,15 @@
 #include "VulkanDevice.h"
 #include "VulkanInstance.h"
 #include "VulkanCommandBuffer.h"
+#include "VulkanDeletionQueue.h"
 
-VulkanCommandPool::VulkanCommandPool(QueueFamily queueFamily, std::shared_ptr<VulkanDevice> device_, std::shared_ptr<VulkanInstance> instance_)
+VulkanCommandPool::VulkanCommandPool(QueueFamily queueFamily, std::shared_ptr<VulkanDevice> device_, std::shared_ptr<VulkanInstance> instance_,
+                                     VkCommandPoolCreateFlags flags)
     : device(device_), instance(instance_) {
 
     VkCommandPoolCreateInfo poolInfo{};
     poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-    poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    poolInfo.flags = flags;
     poolInfo.queueFamilyIndex = instance->GetQueueFamilyIndex(queueFamily);
 
     if (vkCreateCommandPool(device->Handle(), &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
@@ -16,11 +18,18 @@ VulkanCommandPool::VulkanCommandPool(QueueFamily queueFamily, std::shared_ptr<Vu
     }
 }
 
-std::shared_ptr<VulkanCommandBuffer> VulkanCommandPool::AllocateBuffer() {
+VulkanCommandPool::~VulkanCommandPool() {
+    VkDevice deviceHandle = device->Handle();
+    device->GetDeletionQueue()->Enqueue([deviceHandle, commandPool = commandPool]() mutable {
+        VkDestroy(vkDestroyCommandPool, deviceHandle, commandPool);
+    });
+}
+
+std::shared_ptr<VulkanCommandBuffer> VulkanCommandPool::AllocateBuffer(VkCommandBufferLevel level) {
     VkCommandBufferAllocateInfo allocInfo{};
     allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
     allocInfo.commandPool = commandPool;
-    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.level = level;
     allocInfo.commandBufferCount = 1;
 
     VkCommandBuffer commandBufferHandle;
@@ -28,5 +37,9 @@ std::shared_ptr<VulkanCommandBuffer> VulkanCommandPool::AllocateBuffer() {
         throw std::runtime_error("failed to allocate command buffers!");
     }
 
-    return std::make_shared<VulkanCommandBuffer>(commandBufferHandle, device, this->shared_from_this());
+    return std::make_shared<VulkanCommandBuffer>(commandBufferHandle, device, this->shared_from_this(), level);
+}
+
+void VulkanCommandPool::Reset() {
+    vkResetCommandPool(device->Handle(), commandPool, 0);
 }
@@ -6,9 +6,15 @@ class VulkanCommandPool : public std::enable_shared_from_this<VulkanCommandPool>
     VK_NON_COPIABLE(VulkanCommandPool)
 
 public:
-    VulkanCommandPool(QueueFamily queueType, std::shared_ptr<VulkanDevice> device_, std::shared_ptr<VulkanInstance> instance_);
+    VulkanCommandPool(QueueFamily queueType, std::shared_ptr<VulkanDevice> device_, std::shared_ptr<VulkanInstance> instance_,
+                      VkCommandPoolCreateFlags flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
 
-    std::shared_ptr<VulkanCommandBuffer> AllocateBuffer();
+    ~VulkanCommandPool();
+
+    std::shared_ptr<VulkanCommandBuffer> AllocateBuffer(VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+
+    // Returns every command buffer of the pool to the initial state at once
+    void Reset();
 
 private:
     std::shared_ptr<VulkanDevice> device;
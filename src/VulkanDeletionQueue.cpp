@@ -0,0 +1,51 @@
+#include "VulkanDeletionQueue.h"
+
+VulkanDeletionQueue::VulkanDeletionQueue(std::shared_ptr<VulkanScheduler> scheduler_) : scheduler(scheduler_) {
+}
+
+VulkanDeletionQueue::~VulkanDeletionQueue() {
+    Flush();
+}
+
+void VulkanDeletionQueue::Enqueue(Deleter deleter) {
+    Entry entry{};
+    entry.graphicsTicket = scheduler->GetLastTicket(QueueFamily::Graphics);
+    entry.computeTicket = scheduler->GetLastTicket(QueueFamily::Compute);
+    entry.transferTicket = scheduler->GetLastTicket(QueueFamily::Transfer);
+    entry.deleter = std::move(deleter);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.push_back(std::move(entry));
+}
+
+bool VulkanDeletionQueue::IsComplete(const Entry &entry) {
+    return scheduler->IsComplete(entry.graphicsTicket) && scheduler->IsComplete(entry.computeTicket) && scheduler->IsComplete(entry.transferTicket);
+}
+
+void VulkanDeletionQueue::Collect() {
+    // Tickets only grow, so the entries complete in the order they were enqueued
+    std::vector<Deleter> completed;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        while (!entries.empty() && IsComplete(entries.front())) {
+            completed.push_back(std::move(entries.front().deleter));
+            entries.pop_front();
+        }
+    }
+
+    // Deleters may release other wrappers that enqueue again, so they run without holding the lock
+    for (auto &deleter: completed)
+        deleter();
+}
+
+void VulkanDeletionQueue::Flush() {
+    scheduler->WaitIdle();
+
+    while (GetPendingCount() > 0)
+        Collect();
+}
+
+size_t VulkanDeletionQueue::GetPendingCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <mutex>
+
+#include "vk_common.h"
+#include "VulkanScheduler.h"
+
+// Defers the destruction of Vulkan objects until the GPU no longer uses them. An enqueued deleter
+// is tagged with the last submitted ticket of every queue, and runs once all of them have completed.
+// Wrappers enqueue from their destructors, so dropping the last reference is always safe, even while
+// frames that still reference the object are in flight.
+class VulkanDeletionQueue {
+    VK_NON_COPIABLE(VulkanDeletionQueue)
+
+public:
+    using Deleter = std::function<void()>;
+
+    VulkanDeletionQueue(std::shared_ptr<VulkanScheduler> scheduler_);
+
+    ~VulkanDeletionQueue();
+
+    void Enqueue(Deleter deleter);
+
+    // Runs every deleter whose submissions have completed, meant to be called once per frame
+    void Collect();
+
+    // Waits for all queues and runs every remaining deleter
+    void Flush();
+
+    size_t GetPendingCount();
+
+private:
+    struct Entry {
+        VulkanTicket graphicsTicket;
+        VulkanTicket computeTicket;
+        VulkanTicket transferTicket;
+        Deleter deleter;
+    };
+
+    bool IsComplete(const Entry &entry);
+
+private:
+    std::shared_ptr<VulkanScheduler> scheduler;
+
+    std::mutex mutex;
+    std::deque<Entry> entries;
+};
@@ -0,0 +1,124 @@
+#include "VulkanDescriptorAllocator.h"
+#include "VulkanDeletionQueue.h"
+
+#include <algorithm>
+
+// Upper bound for the growth of the pool size
+static constexpr uint32_t MaxSetsPerPool = 4096;
+
+VulkanDescriptorAllocator::VulkanDescriptorAllocator(VkDevice device_, std::shared_ptr<VulkanDeletionQueue> deletionQueue_, uint32_t setsPerPool_,
+                                                     std::vector<VulkanDescriptorPoolRatio> poolRatios_)
+    : device(device_), deletionQueue(deletionQueue_), poolRatios(std::move(poolRatios_)), setsPerPool(setsPerPool_) {
+}
+
+VulkanDescriptorAllocator::~VulkanDescriptorAllocator() {
+    std::vector<VkDescriptorPool> pools = usedPools;
+    pools.insert(pools.end(), freePools.begin(), freePools.end());
+    if (currentPool != VK_NULL_HANDLE)
+        pools.push_back(currentPool);
+
+    // Destroying a pool frees all sets allocated from it
+    deletionQueue->Enqueue([deviceHandle = device, pools]() mutable {
+        for (auto &pool: pools)
+            VkDestroy(vkDestroyDescriptorPool, deviceHandle, pool);
+    });
+}
+
+VkDescriptorSet VulkanDescriptorAllocator::Allocate(VkDescriptorSetLayout layout) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (currentPool == VK_NULL_HANDLE)
+        currentPool = GrabPool();
+
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = currentPool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &layout;
+
+    VkDescriptorSet descriptorSet;
+    VkResult result = vkAllocateDescriptorSets(device, &allocInfo, &descriptorSet);
+    if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL) {
+        usedPools.push_back(currentPool);
+        currentPool = GrabPool();
+
+        allocInfo.descriptorPool = currentPool;
+        result = vkAllocateDescriptorSets(device, &allocInfo, &descriptorSet);
+    }
+
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate descriptor set!");
+    }
+
+    return descriptorSet;
+}
+
+void VulkanDescriptorAllocator::ResetPools() {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (currentPool != VK_NULL_HANDLE)
+        usedPools.push_back(currentPool);
+    currentPool = VK_NULL_HANDLE;
+
+    for (auto pool: usedPools) {
+        vkResetDescriptorPool(device, pool, 0);
+        freePools.push_back(pool);
+    }
+    usedPools.clear();
+}
+
+size_t VulkanDescriptorAllocator::GetPoolCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return usedPools.size() + freePools.size() + (currentPool != VK_NULL_HANDLE ? 1 : 0);
+}
+
+std::vector<VulkanDescriptorPoolRatio> VulkanDescriptorAllocator::DefaultPoolRatios() {
+    return {
+        {VK_DESCRIPTOR_TYPE_SAMPLER,                0.5f},
+        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4.0f},
+        {VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,          4.0f},
+        {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,          1.0f},
+        {VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER,   1.0f},
+        {VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER,   1.0f},
+        {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,         2.0f},
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,         2.0f},
+        {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.0f},
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1.0f},
+        {VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT,       0.5f},
+    };
+}
+
+VkDescriptorPool VulkanDescriptorAllocator::GrabPool() {
+    if (!freePools.empty()) {
+        VkDescriptorPool pool = freePools.back();
+        freePools.pop_back();
+        return pool;
+    }
+
+    VkDescriptorPool pool = CreatePool(setsPerPool);
+    setsPerPool = std::min(MaxSetsPerPool, setsPerPool + setsPerPool / 2);
+    return pool;
+}
+
+VkDescriptorPool VulkanDescriptorAllocator::CreatePool(uint32_t setCount) {
+    std::vector<VkDescriptorPoolSize> poolSizes;
+    for (const auto &poolRatio: poolRatios) {
+        VkDescriptorPoolSize poolSize;
+        poolSize.type = poolRatio.type;
+        poolSize.descriptorCount = std::max(1u, static_cast<uint32_t>(poolRatio.ratio * setCount));
+        poolSizes.push_back(poolSize);
+    }
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes = poolSizes.data();
+    poolInfo.maxSets = setCount;
+
+    VkDescriptorPool pool;
+    if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &pool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create descriptor pool!");
+    }
+
+    return pool;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <mutex>
+
+#include "vk_common.h"
+
+// Share of a pool's set count that is reserved for one descriptor type
+struct VulkanDescriptorPoolRatio {
+    VkDescriptorType type;
+    float ratio;
+};
+
+// Hands out descriptor sets from a growing list of pools. When the current pool runs out, the next
+// one is taken from the free list or created, each new pool with room for more sets than the last.
+// Sets are never freed one by one, they live until their pool is reset or the allocator is destroyed.
+class VulkanDescriptorAllocator {
+    VK_NON_COPIABLE(VulkanDescriptorAllocator)
+
+public:
+    VulkanDescriptorAllocator(VkDevice device_, std::shared_ptr<VulkanDeletionQueue> deletionQueue_, uint32_t setsPerPool_ = 64,
+                              std::vector<VulkanDescriptorPoolRatio> poolRatios_ = DefaultPoolRatios());
+
+    ~VulkanDescriptorAllocator();
+
+    VkDescriptorSet Allocate(VkDescriptorSetLayout layout);
+
+    // Returns every set to its pool. Must only be called once the GPU is done with all of them,
+    // frame contexts do it for their transient sets when the frame starts over.
+    void ResetPools();
+
+    size_t GetPoolCount();
+
+public:
+    static std::vector<VulkanDescriptorPoolRatio> DefaultPoolRatios();
+
+private:
+    VkDescriptorPool GrabPool();
+
+    VkDescriptorPool CreatePool(uint32_t setCount);
+
+private:
+    VkDevice device;
+    std::shared_ptr<VulkanDeletionQueue> deletionQueue;
+    std::vector<VulkanDescriptorPoolRatio> poolRatios;
+
+    std::mutex mutex;
+    uint32_t setsPerPool;
+    VkDescriptorPool currentPool = VK_NULL_HANDLE;
+    std::vector<VkDescriptorPool> usedPools;
+    std::vector<VkDescriptorPool> freePools;
+};
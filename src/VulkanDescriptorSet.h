@@ -2,17 +2,22 @@
 
 #include "vk_common.h"
 
-class VulkanDescriptorSet {
+class VulkanDescriptorSet : public std::enable_shared_from_this<VulkanDescriptorSet> {
     VK_NON_COPIABLE(VulkanDescriptorSet)
 
 public:
     VulkanDescriptorSet(std::shared_ptr<VulkanDevice> device_, VkDescriptorSet descriptorSet_);
 
+    // Each write is its own driver call, use VulkanDescriptorWriter or VulkanDescriptorUpdateTemplate to update several bindings at once
     void WriteUniformBuffer(int bindingIndex, std::shared_ptr<VulkanBuffer> buffer, int bufferSize);
 
+    void WriteDynamicUniformBuffer(int bindingIndex, std::shared_ptr<VulkanBuffer> buffer, int range);
+
     void WriteImage(int bindingIndex, std::shared_ptr<VulkanTextureSampler> textureSampler, std::shared_ptr<VulkanImageView> imageView);
 
-    void Bind(std::shared_ptr<VulkanCommandBuffer> commandBuffer, std::shared_ptr<VulkanGraphicsPipeline> pipeline);
+    // Sets are bound independently per set index, binding the set that is already bound there is skipped
+    void Bind(std::shared_ptr<VulkanCommandBuffer> commandBuffer, std::shared_ptr<VulkanGraphicsPipeline> pipeline,
+              const std::vector<uint32_t> &dynamicOffsets = {}, uint32_t setIndex = 0);
 
 private:
     std::shared_ptr<VulkanDevice> device;
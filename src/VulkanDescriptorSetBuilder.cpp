@@ -1,6 +1,11 @@
 #include "VulkanDescriptorSetBuilder.h"
 #include "VulkanDescriptorSet.h"
 #include "VulkanDevice.h"
+#include "VulkanShader.h"
+#include "VulkanDeletionQueue.h"
+#include "VulkanDescriptorAllocator.h"
+#include "VulkanDescriptorUpdateTemplate.h"
+#include "VulkanGraphicsPipeline.h"
 
 VulkanDescriptorSetBuilder::VulkanDescriptorSetBuilder(std::shared_ptr<VulkanDevice> device_, int swapChainCount_)
     : swapChainCount(swapChainCount_), device(device_) {
@@ -8,68 +13,75 @@ VulkanDescriptorSetBuilder::VulkanDescriptorSetBuilder(std::shared_ptr<VulkanDev
 
 VulkanDescriptorSetBuilder::~VulkanDescriptorSetBuilder() {
     layoutBindings.clear();
-    poolSizes.clear();
+
+    // The sets stay with the pools of their allocator, only the layout belongs to the builder
+    VkDevice deviceHandle = device->Handle();
+    device->GetDeletionQueue()->Enqueue([deviceHandle, descriptorSetLayout = descriptorSetLayout]() mutable {
+        VkDestroy(vkDestroyDescriptorSetLayout, deviceHandle, descriptorSetLayout);
+    });
 }
 
 void VulkanDescriptorSetBuilder::AddLayoutSlot(ShaderStage shaderStage, int slotIndex, ShaderResourceType type, int count) {
+    AddLayoutBinding((VkShaderStageFlags) shaderStage, slotIndex, (VkDescriptorType) type, count);
+}
+
+void VulkanDescriptorSetBuilder::AddReflectedSlots(const std::vector<std::shared_ptr<VulkanShader>> &shaders, uint32_t set) {
+    for (const auto &binding: VulkanShader::MergeBindings(shaders)) {
+        if (binding.set != set)
+            continue;
+
+        if (binding.count == 0) {
+            throw std::runtime_error("runtime sized descriptor arrays are not supported by VulkanDescriptorSetBuilder!");
+        }
+        AddLayoutBinding(binding.stages, binding.binding, binding.type, binding.count);
+    }
+}
+
+void VulkanDescriptorSetBuilder::SetSlotType(int slotIndex, ShaderResourceType type) {
+    for (auto &layoutBinding: layoutBindings) {
+        if (layoutBinding.binding == static_cast<uint32_t>(slotIndex)) {
+            layoutBinding.descriptorType = (VkDescriptorType) type;
+            return;
+        }
+    }
+
+    throw std::runtime_error("descriptor set layout has no slot with this index!");
+}
+
+void VulkanDescriptorSetBuilder::AddLayoutBinding(VkShaderStageFlags stages, uint32_t binding, VkDescriptorType type, uint32_t count) {
     VkDescriptorSetLayoutBinding layoutBinding{};
-    layoutBinding.binding = slotIndex;
+    layoutBinding.binding = binding;
     layoutBinding.descriptorCount = count;
-    layoutBinding.descriptorType = (VkDescriptorType) type;
+    layoutBinding.descriptorType = type;
     layoutBinding.pImmutableSamplers = nullptr;
-    layoutBinding.stageFlags = (VkShaderStageFlags) shaderStage;
+    layoutBinding.stageFlags = stages;
     layoutBindings.push_back(layoutBinding);
-
-    VkDescriptorPoolSize poolSize;
-    poolSize.type = (VkDescriptorType) type;
-    poolSize.descriptorCount = static_cast<uint32_t>(swapChainCount);
-    poolSizes.push_back(poolSize);
 }
 
-std::vector<std::shared_ptr<VulkanDescriptorSet>> VulkanDescriptorSetBuilder::Build() {
+std::vector<std::shared_ptr<VulkanDescriptorSet>> VulkanDescriptorSetBuilder::Build(std::shared_ptr<VulkanDescriptorAllocator> allocator) {
     if (layoutBindings.empty()) {
         throw std::runtime_error("no layout slots have been added to this VulkanDescriptorSetBuilder");
     }
 
     // Descriptor Set Layout
-    VkDescriptorSetLayoutCreateInfo layoutInfo{};
-    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-    layoutInfo.bindingCount = static_cast<uint32_t>(layoutBindings.size());
-    layoutInfo.pBindings = layoutBindings.data();
+    if (descriptorSetLayout == VK_NULL_HANDLE) {
+        VkDescriptorSetLayoutCreateInfo layoutInfo{};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutInfo.bindingCount = static_cast<uint32_t>(layoutBindings.size());
+        layoutInfo.pBindings = layoutBindings.data();
 
-    if (vkCreateDescriptorSetLayout(device->Handle(), &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) {
-        throw std::runtime_error("failed to create descriptor set layout!");
+        if (vkCreateDescriptorSetLayout(device->Handle(), &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create descriptor set layout!");
+        }
     }
 
-    // Descriptor Pool
-    VkDescriptorPoolCreateInfo poolInfo{};
-    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
-    poolInfo.pPoolSizes = poolSizes.data();
-    poolInfo.maxSets = static_cast<uint32_t>(swapChainCount);
-
-    VkDescriptorPool descriptorPool;
-    if (vkCreateDescriptorPool(device->Handle(), &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
-        throw std::runtime_error("failed to create descriptor pool!");
-    }
-
-    // Allocate Pools
-    std::vector<VkDescriptorSetLayout> layouts(swapChainCount, descriptorSetLayout);
-    VkDescriptorSetAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    allocInfo.descriptorPool = descriptorPool;
-    allocInfo.descriptorSetCount = swapChainCount;
-    allocInfo.pSetLayouts = layouts.data();
-
-    std::vector<VkDescriptorSet> descriptorSetHandles;
-    descriptorSetHandles.resize(swapChainCount);
-    if (vkAllocateDescriptorSets(device->Handle(), &allocInfo, descriptorSetHandles.data()) != VK_SUCCESS) {
-        throw std::runtime_error("failed to allocate descriptor sets!");
-    }
+    // Allocate Sets
+    if (allocator == nullptr)
+        allocator = device->GetDescriptorAllocator();
 
     std::vector<std::shared_ptr<VulkanDescriptorSet>> descriptorSets;
-    for(int i = 0; i < swapChainCount; i++) {
-        descriptorSets.push_back(std::make_shared<VulkanDescriptorSet>(device, descriptorSetHandles[i]));
+    for (int i = 0; i < swapChainCount; i++) {
+        descriptorSets.push_back(std::make_shared<VulkanDescriptorSet>(device, allocator->Allocate(descriptorSetLayout)));
     }
 
     return descriptorSets;
@@ -78,3 +90,22 @@ std::vector<std::shared_ptr<VulkanDescriptorSet>> VulkanDescriptorSetBuilder::Bu
 VkDescriptorSetLayout VulkanDescriptorSetBuilder::GetLayout() {
     return descriptorSetLayout;
 }
+
+VulkanDescriptorSetLayoutDescription VulkanDescriptorSetBuilder::GetLayoutDescription() {
+    if (descriptorSetLayout == VK_NULL_HANDLE) {
+        throw std::runtime_error("descriptor set layout has not been built yet!");
+    }
+
+    VulkanDescriptorSetLayoutDescription description;
+    description.layout = descriptorSetLayout;
+    description.bindings = layoutBindings;
+    return description;
+}
+
+std::shared_ptr<VulkanDescriptorUpdateTemplate> VulkanDescriptorSetBuilder::CreateUpdateTemplate() {
+    if (descriptorSetLayout == VK_NULL_HANDLE) {
+        throw std::runtime_error("descriptor set layout has not been built yet!");
+    }
+
+    return std::make_shared<VulkanDescriptorUpdateTemplate>(device, descriptorSetLayout, layoutBindings);
+}
@@ -4,6 +4,7 @@
 
 enum class ShaderResourceType {
     UniformBuffer = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+    UniformBufferDynamic = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
     ImageSampler = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER
 };
 
@@ -16,17 +17,31 @@ public:
 
     void AddLayoutSlot(ShaderStage shaderStage, int slotIndex, ShaderResourceType type, int count);
 
-    std::vector<std::shared_ptr<VulkanDescriptorSet>> Build();
+    // Adds every binding of the given set that the shaders declare, merged across their stages
+    void AddReflectedSlots(const std::vector<std::shared_ptr<VulkanShader>> &shaders, uint32_t set = 0);
+
+    // SPIR-V can't tell dynamic buffers apart from plain ones, reflected slots that are used with dynamic offsets are changed here
+    void SetSlotType(int slotIndex, ShaderResourceType type);
+
+    // Creates the layout on the first call. Without an allocator the sets come from the device one, pass the
+    // allocator of a frame context for sets that are only used in that frame.
+    std::vector<std::shared_ptr<VulkanDescriptorSet>> Build(std::shared_ptr<VulkanDescriptorAllocator> allocator = nullptr);
 
     VkDescriptorSetLayout GetLayout();
 
+    // The layout with the bindings it was created from, for pipeline states. Build has to be called first.
+    VulkanDescriptorSetLayoutDescription GetLayoutDescription();
 
+    // Template over every slot of the layout, Build has to be called first
+    std::shared_ptr<VulkanDescriptorUpdateTemplate> CreateUpdateTemplate();
+
+private:
+    void AddLayoutBinding(VkShaderStageFlags stages, uint32_t binding, VkDescriptorType type, uint32_t count);
 
 private:
     std::shared_ptr<VulkanDevice> device;
     std::vector<VkDescriptorSetLayoutBinding> layoutBindings;
-    std::vector<VkDescriptorPoolSize> poolSizes;
     int swapChainCount = -1;
 
-    VkDescriptorSetLayout descriptorSetLayout;
+    VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
 };
@@ -0,0 +1,84 @@
+#include "VulkanDescriptorUpdateTemplate.h"
+#include "VulkanDevice.h"
+#include "VulkanBuffer.h"
+#include "VulkanImageView.h"
+#include "VulkanTextureSampler.h"
+#include "VulkanDescriptorSet.h"
+#include "VulkanDeletionQueue.h"
+
+VulkanDescriptorUpdateTemplate::VulkanDescriptorUpdateTemplate(std::shared_ptr<VulkanDevice> device_, VkDescriptorSetLayout descriptorSetLayout,
+                                                               const std::vector<VkDescriptorSetLayoutBinding> &layoutBindings)
+    : device(device_) {
+    std::vector<VkDescriptorUpdateTemplateEntry> entries;
+    size_t dataCount = 0;
+    for (const auto &layoutBinding: layoutBindings) {
+        VkDescriptorUpdateTemplateEntry entry{};
+        entry.dstBinding = layoutBinding.binding;
+        entry.dstArrayElement = 0;
+        entry.descriptorCount = layoutBinding.descriptorCount;
+        entry.descriptorType = layoutBinding.descriptorType;
+        entry.offset = dataCount * sizeof(DescriptorData);
+        entry.stride = sizeof(DescriptorData);
+        entries.push_back(entry);
+
+        bindingSlots[layoutBinding.binding] = {dataCount, layoutBinding.descriptorCount};
+        dataCount += layoutBinding.descriptorCount;
+    }
+    data.resize(dataCount);
+    staged.resize(dataCount, false);
+
+    VkDescriptorUpdateTemplateCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+    createInfo.descriptorUpdateEntryCount = static_cast<uint32_t>(entries.size());
+    createInfo.pDescriptorUpdateEntries = entries.data();
+    createInfo.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+    createInfo.descriptorSetLayout = descriptorSetLayout;
+
+    if (vkCreateDescriptorUpdateTemplate(device->Handle(), &createInfo, nullptr, &updateTemplate) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create descriptor update template!");
+    }
+}
+
+VulkanDescriptorUpdateTemplate::~VulkanDescriptorUpdateTemplate() {
+    // Only used on the host, so no GPU work can depend on it
+    VkDestroy(vkDestroyDescriptorUpdateTemplate, device->Handle(), updateTemplate);
+}
+
+void VulkanDescriptorUpdateTemplate::SetBuffer(uint32_t binding, std::shared_ptr<VulkanBuffer> buffer, VkDeviceSize offset, VkDeviceSize range,
+                                               uint32_t arrayElement) {
+    auto &bufferInfo = GetData(binding, arrayElement).buffer;
+    bufferInfo.buffer = buffer->Handle();
+    bufferInfo.offset = offset;
+    bufferInfo.range = range;
+}
+
+void VulkanDescriptorUpdateTemplate::SetImage(uint32_t binding, std::shared_ptr<VulkanTextureSampler> textureSampler,
+                                              std::shared_ptr<VulkanImageView> imageView, VkImageLayout imageLayout, uint32_t arrayElement) {
+    auto &imageInfo = GetData(binding, arrayElement).image;
+    imageInfo.imageLayout = imageLayout;
+    imageInfo.imageView = imageView != nullptr ? imageView->Handle() : VK_NULL_HANDLE;
+    imageInfo.sampler = textureSampler != nullptr ? textureSampler->Handle() : VK_NULL_HANDLE;
+}
+
+void VulkanDescriptorUpdateTemplate::Update(std::shared_ptr<VulkanDescriptorSet> descriptorSet) {
+    for (const auto &[binding, slot]: bindingSlots) {
+        for (uint32_t i = 0; i < slot.second; i++) {
+            if (!staged[slot.first + i]) {
+                throw std::runtime_error("descriptor update template binding " + std::to_string(binding) + " element " +
+                                         std::to_string(i) + " has not been staged!");
+            }
+        }
+    }
+
+    vkUpdateDescriptorSetWithTemplate(device->Handle(), descriptorSet->Handle(), updateTemplate, data.data());
+}
+
+VulkanDescriptorUpdateTemplate::DescriptorData &VulkanDescriptorUpdateTemplate::GetData(uint32_t binding, uint32_t arrayElement) {
+    auto slot = bindingSlots.find(binding);
+    if (slot == bindingSlots.end() || arrayElement >= slot->second.second) {
+        throw std::out_of_range("descriptor update template has no such binding or array element!");
+    }
+
+    staged[slot->second.first + arrayElement] = true;
+    return data[slot->second.first + arrayElement];
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <unordered_map>
+
+#include "vk_common.h"
+
+// Writes every binding of a set layout with one vkUpdateDescriptorSetWithTemplate call. The descriptors are staged
+// in a packed array that the driver reads directly, so updating another set with the same contents costs one call.
+// Staging is not thread safe, every thread needs its own template.
+class VulkanDescriptorUpdateTemplate {
+    VK_NON_COPIABLE(VulkanDescriptorUpdateTemplate)
+
+public:
+    VulkanDescriptorUpdateTemplate(std::shared_ptr<VulkanDevice> device_, VkDescriptorSetLayout descriptorSetLayout,
+                                   const std::vector<VkDescriptorSetLayoutBinding> &layoutBindings);
+
+    ~VulkanDescriptorUpdateTemplate();
+
+    void SetBuffer(uint32_t binding, std::shared_ptr<VulkanBuffer> buffer, VkDeviceSize offset, VkDeviceSize range, uint32_t arrayElement = 0);
+
+    void SetImage(uint32_t binding, std::shared_ptr<VulkanTextureSampler> textureSampler, std::shared_ptr<VulkanImageView> imageView,
+                  VkImageLayout imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, uint32_t arrayElement = 0);
+
+    // Writes all staged descriptors into the set. Every array element of every binding has to be staged first,
+    // the template writes all of them and null descriptors are not valid without the nullDescriptor feature.
+    void Update(std::shared_ptr<VulkanDescriptorSet> descriptorSet);
+
+private:
+    union DescriptorData {
+        VkDescriptorImageInfo image;
+        VkDescriptorBufferInfo buffer;
+        VkBufferView texelBuffer;
+    };
+
+    DescriptorData &GetData(uint32_t binding, uint32_t arrayElement);
+
+private:
+    std::shared_ptr<VulkanDevice> device;
+
+    std::vector<DescriptorData> data;
+    std::vector<bool> staged; // Parallel to data
+    std::unordered_map<uint32_t, std::pair<size_t, uint32_t>> bindingSlots; // First index into data and descriptor count
+
+VK_HANDLE(VkDescriptorUpdateTemplate, updateTemplate);
+};
@@ -0,0 +1,61 @@
+#include "VulkanDescriptorWriter.h"
+#include "VulkanDevice.h"
+#include "VulkanBuffer.h"
+#include "VulkanImageView.h"
+#include "VulkanTextureSampler.h"
+#include "VulkanDescriptorSet.h"
+
+VulkanDescriptorWriter::VulkanDescriptorWriter(std::shared_ptr<VulkanDevice> device_) : device(device_) {
+}
+
+void VulkanDescriptorWriter::WriteBuffer(std::shared_ptr<VulkanDescriptorSet> descriptorSet, uint32_t binding, VkDescriptorType type,
+                                         std::shared_ptr<VulkanBuffer> buffer, VkDeviceSize offset, VkDeviceSize range, uint32_t arrayElement) {
+    VkDescriptorBufferInfo &bufferInfo = bufferInfos.emplace_back();
+    bufferInfo.buffer = buffer->Handle();
+    bufferInfo.offset = offset;
+    bufferInfo.range = range;
+
+    VkWriteDescriptorSet descriptorWrite{};
+    descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrite.dstSet = descriptorSet->Handle();
+    descriptorWrite.dstBinding = binding;
+    descriptorWrite.dstArrayElement = arrayElement;
+    descriptorWrite.descriptorType = type;
+    descriptorWrite.descriptorCount = 1;
+    descriptorWrite.pBufferInfo = &bufferInfo;
+    writes.push_back(descriptorWrite);
+}
+
+void VulkanDescriptorWriter::WriteImage(std::shared_ptr<VulkanDescriptorSet> descriptorSet, uint32_t binding, VkDescriptorType type,
+                                        std::shared_ptr<VulkanTextureSampler> textureSampler, std::shared_ptr<VulkanImageView> imageView,
+                                        VkImageLayout imageLayout, uint32_t arrayElement) {
+    VkDescriptorImageInfo &imageInfo = imageInfos.emplace_back();
+    imageInfo.imageLayout = imageLayout;
+    imageInfo.imageView = imageView != nullptr ? imageView->Handle() : VK_NULL_HANDLE;
+    imageInfo.sampler = textureSampler != nullptr ? textureSampler->Handle() : VK_NULL_HANDLE;
+
+    VkWriteDescriptorSet descriptorWrite{};
+    descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrite.dstSet = descriptorSet->Handle();
+    descriptorWrite.dstBinding = binding;
+    descriptorWrite.dstArrayElement = arrayElement;
+    descriptorWrite.descriptorType = type;
+    descriptorWrite.descriptorCount = 1;
+    descriptorWrite.pImageInfo = &imageInfo;
+    writes.push_back(descriptorWrite);
+}
+
+bool VulkanDescriptorWriter::IsEmpty() const {
+    return writes.empty();
+}
+
+void VulkanDescriptorWriter::Flush() {
+    if (writes.empty())
+        return;
+
+    vkUpdateDescriptorSets(device->Handle(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+    writes.clear();
+    bufferInfos.clear();
+    imageInfos.clear();
+}
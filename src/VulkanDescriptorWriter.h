@@ -0,0 +1,35 @@
+#pragma once
+
+#include <deque>
+
+#include "vk_common.h"
+
+// Collects descriptor writes for any number of sets and applies them with a single vkUpdateDescriptorSets call.
+// The written objects only have to stay alive until the sets are used, not until Flush.
+class VulkanDescriptorWriter {
+    VK_NON_COPIABLE(VulkanDescriptorWriter)
+
+public:
+    explicit VulkanDescriptorWriter(std::shared_ptr<VulkanDevice> device_);
+
+    void WriteBuffer(std::shared_ptr<VulkanDescriptorSet> descriptorSet, uint32_t binding, VkDescriptorType type,
+                     std::shared_ptr<VulkanBuffer> buffer, VkDeviceSize offset, VkDeviceSize range, uint32_t arrayElement = 0);
+
+    void WriteImage(std::shared_ptr<VulkanDescriptorSet> descriptorSet, uint32_t binding, VkDescriptorType type,
+                    std::shared_ptr<VulkanTextureSampler> textureSampler, std::shared_ptr<VulkanImageView> imageView,
+                    VkImageLayout imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, uint32_t arrayElement = 0);
+
+    bool IsEmpty() const;
+
+    // Applies every collected write, does nothing if there are none
+    void Flush();
+
+private:
+    std::shared_ptr<VulkanDevice> device;
+
+    std::vector<VkWriteDescriptorSet> writes;
+
+    // The writes point into these, a deque keeps the addresses stable while it grows
+    std::deque<VkDescriptorBufferInfo> bufferInfos;
+    std::deque<VkDescriptorImageInfo> imageInfos;
+};
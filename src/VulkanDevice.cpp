@@ -1,11 +1,23 @@
 #include "VulkanDevice.h"
+
+#include <algorithm>
+
 #include "VulkanInstance.h"
+#include "VulkanMemoryAllocator.h"
+#include "VulkanScheduler.h"
+#include "VulkanDeletionQueue.h"
+#include "VulkanPipelineCache.h"
+#include "VulkanDescriptorAllocator.h"
 
-VulkanDevice::VulkanDevice(std::shared_ptr<VulkanInstance> instance_) : instance(instance_) {
+VulkanDevice::VulkanDevice(std::shared_ptr<VulkanInstance> instance_, const std::string &pipelineCachePath) : instance(instance_) {
     QueueFamilyIndices indices = instance->FindQueueFamilies();
 
     std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
     std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily.value(), indices.presentFamily.value()};
+    if (indices.computeFamily.has_value())
+        uniqueQueueFamilies.insert(indices.computeFamily.value());
+    if (indices.transferFamily.has_value())
+        uniqueQueueFamilies.insert(indices.transferFamily.value());
 
     float queuePriority = 1.0f;
     for (uint32_t queueFamily: uniqueQueueFamilies) {
@@ -28,8 +40,40 @@ VulkanDevice::VulkanDevice(std::shared_ptr<VulkanInstance> instance_) : instance
 
     createInfo.pEnabledFeatures = &deviceFeatures;
 
-    createInfo.enabledExtensionCount = static_cast<uint32_t>(VulkanInstance::DeviceExtensions.size());
-    createInfo.ppEnabledExtensionNames = VulkanInstance::DeviceExtensions.data();
+    // Submissions are tracked with timeline semaphores instead of fences
+    VkPhysicalDeviceVulkan12Features vulkan12Features{};
+    vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    vulkan12Features.timelineSemaphore = VK_TRUE;
+    createInfo.pNext = &vulkan12Features;
+
+    // Descriptor indexing backs the optional bindless texture table
+    bindlessSupported = IsBindlessSupported(instance->PhysicalDeviceHandle());
+    if (bindlessSupported) {
+        // The table is indexed with values that aren't compile time constants
+        deviceFeatures.shaderSampledImageArrayDynamicIndexing = VK_TRUE;
+        vulkan12Features.descriptorIndexing = VK_TRUE;
+        vulkan12Features.runtimeDescriptorArray = VK_TRUE;
+        vulkan12Features.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+        vulkan12Features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+        vulkan12Features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+        vulkan12Features.descriptorBindingPartiallyBound = VK_TRUE;
+        vulkan12Features.descriptorBindingVariableDescriptorCount = VK_TRUE;
+    }
+
+    // Barriers are recorded with vkCmdPipelineBarrier2
+    VkPhysicalDeviceVulkan13Features vulkan13Features{};
+    vulkan13Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+    vulkan13Features.synchronization2 = VK_TRUE;
+    vulkan12Features.pNext = &vulkan13Features;
+
+    // Optional extensions are only enabled when the physical device supports them
+    std::vector<const char *> extensions = VulkanInstance::DeviceExtensions;
+    bool memoryBudgetSupported = instance->IsDeviceExtensionSupported(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    if (memoryBudgetSupported)
+        extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
+    createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+    createInfo.ppEnabledExtensionNames = extensions.data();
 
     if (VulkanInstance::EnableValidationLayers) {
         createInfo.enabledLayerCount = static_cast<uint32_t>(VulkanInstance::ValidationLayers.size());
@@ -44,6 +88,15 @@ VulkanDevice::VulkanDevice(std::shared_ptr<VulkanInstance> instance_) : instance
 
     vkGetDeviceQueue(device, indices.graphicsFamily.value(), 0, &graphicsQueue);
     vkGetDeviceQueue(device, indices.presentFamily.value(), 0, &presentQueue);
+    vkGetDeviceQueue(device, indices.computeFamily.value_or(indices.graphicsFamily.value()), 0, &computeQueue);
+    vkGetDeviceQueue(device, indices.transferFamily.value_or(indices.graphicsFamily.value()), 0, &transferQueue);
+    hasDedicatedTransferQueue = indices.transferFamily.has_value();
+
+    memoryAllocator = std::make_shared<VulkanMemoryAllocator>(device, instance, memoryBudgetSupported);
+    scheduler = std::make_shared<VulkanScheduler>(device, graphicsQueue, computeQueue, transferQueue);
+    deletionQueue = std::make_shared<VulkanDeletionQueue>(scheduler);
+    pipelineCache = std::make_shared<VulkanPipelineCache>(device, instance, pipelineCachePath);
+    descriptorAllocator = std::make_shared<VulkanDescriptorAllocator>(device, deletionQueue);
 }
 
 void VulkanDevice::WaitIdle() {
@@ -58,6 +111,79 @@ VkQueue VulkanDevice::GetPresentQueue() {
     return presentQueue;
 }
 
+VkQueue VulkanDevice::GetComputeQueue() {
+    return computeQueue;
+}
+
+VkQueue VulkanDevice::GetTransferQueue() {
+    return transferQueue;
+}
+
+bool VulkanDevice::HasDedicatedTransferQueue() const {
+    return hasDedicatedTransferQueue;
+}
+
+std::shared_ptr<VulkanMemoryAllocator> VulkanDevice::GetMemoryAllocator() {
+    return memoryAllocator;
+}
+
+std::shared_ptr<VulkanScheduler> VulkanDevice::GetScheduler() {
+    return scheduler;
+}
+
+std::shared_ptr<VulkanDeletionQueue> VulkanDevice::GetDeletionQueue() {
+    return deletionQueue;
+}
+
+std::shared_ptr<VulkanPipelineCache> VulkanDevice::GetPipelineCache() {
+    return pipelineCache;
+}
+
+std::shared_ptr<VulkanDescriptorAllocator> VulkanDevice::GetDescriptorAllocator() {
+    return descriptorAllocator;
+}
+
+bool VulkanDevice::IsBindlessSupported() const {
+    return bindlessSupported;
+}
+
+uint32_t VulkanDevice::GetMaxBindlessTextures() {
+    VkPhysicalDeviceDescriptorIndexingProperties indexingProperties{};
+    indexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+
+    VkPhysicalDeviceProperties2 properties{};
+    properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    properties.pNext = &indexingProperties;
+    vkGetPhysicalDeviceProperties2(instance->PhysicalDeviceHandle(), &properties);
+
+    // Combined image samplers count against both the image and the sampler limits
+    return std::min({indexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+                     indexingProperties.maxPerStageDescriptorUpdateAfterBindSamplers,
+                     indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages,
+                     indexingProperties.maxDescriptorSetUpdateAfterBindSamplers});
+}
+
+bool VulkanDevice::IsBindlessSupported(VkPhysicalDevice physicalDevice) {
+    VkPhysicalDeviceVulkan12Features vulkan12Features{};
+    vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+    VkPhysicalDeviceFeatures2 supportedFeatures{};
+    supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    supportedFeatures.pNext = &vulkan12Features;
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &supportedFeatures);
+
+    return supportedFeatures.features.shaderSampledImageArrayDynamicIndexing &&
+           vulkan12Features.descriptorIndexing && vulkan12Features.runtimeDescriptorArray &&
+           vulkan12Features.shaderSampledImageArrayNonUniformIndexing && vulkan12Features.descriptorBindingSampledImageUpdateAfterBind &&
+           vulkan12Features.descriptorBindingUpdateUnusedWhilePending && vulkan12Features.descriptorBindingPartiallyBound &&
+           vulkan12Features.descriptorBindingVariableDescriptorCount;
+}
+
 VulkanDevice::~VulkanDevice() {
+    pipelineCache.reset(); // Saves the cache to disk
+    descriptorAllocator.reset(); // Enqueues its pools, which are destroyed with the deletion queue below
+    deletionQueue.reset(); // Runs the remaining deleters, which may still free memory through the allocator
+    scheduler.reset();
+    memoryAllocator.reset();
     vkDestroyDevice(device, nullptr);
 }
\ No newline at end of file
@@ -1,12 +1,14 @@
 #pragma once
 
+#include <string>
+
 #include "vk_common.h"
 
 class VulkanDevice {
     VK_NON_COPIABLE(VulkanDevice)
 
 public:
-    VulkanDevice(std::shared_ptr<VulkanInstance> instance_);
+    VulkanDevice(std::shared_ptr<VulkanInstance> instance_, const std::string &pipelineCachePath = "pipeline_cache.bin");
 
     ~VulkanDevice();
 
@@ -14,12 +16,44 @@ public:
 
     VkQueue GetGraphicsQueue();
     VkQueue GetPresentQueue();
+    VkQueue GetComputeQueue();
+    VkQueue GetTransferQueue();
+
+    bool HasDedicatedTransferQueue() const;
+
+    std::shared_ptr<VulkanMemoryAllocator> GetMemoryAllocator();
+
+    std::shared_ptr<VulkanScheduler> GetScheduler();
+
+    std::shared_ptr<VulkanDeletionQueue> GetDeletionQueue();
+
+    std::shared_ptr<VulkanPipelineCache> GetPipelineCache();
+
+    // For descriptor sets that live as long as the objects that own them, per-frame sets come from the frame contexts
+    std::shared_ptr<VulkanDescriptorAllocator> GetDescriptorAllocator();
+
+    // Whether the descriptor indexing features VulkanBindlessTextureTable relies on are enabled
+    bool IsBindlessSupported() const;
+
+    uint32_t GetMaxBindlessTextures();
+
+private:
+    static bool IsBindlessSupported(VkPhysicalDevice physicalDevice);
 
 private:
     std::shared_ptr<VulkanInstance> instance;
+    std::shared_ptr<VulkanMemoryAllocator> memoryAllocator;
+    std::shared_ptr<VulkanScheduler> scheduler;
+    std::shared_ptr<VulkanDeletionQueue> deletionQueue;
+    std::shared_ptr<VulkanPipelineCache> pipelineCache;
+    std::shared_ptr<VulkanDescriptorAllocator> descriptorAllocator;
 
 private:
     VkQueue graphicsQueue;
     VkQueue presentQueue;
+    VkQueue computeQueue;
+    VkQueue transferQueue;
+    bool hasDedicatedTransferQueue = false;
+    bool bindlessSupported = false;
 VK_HANDLE(VkDevice, device);
 };
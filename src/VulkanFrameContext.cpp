@@ -0,0 +1,57 @@
+#include "VulkanFrameContext.h"
+#include "VulkanDevice.h"
+#include "VulkanInstance.h"
+#include "VulkanCommandPool.h"
+#include "VulkanCommandBuffer.h"
+#include "VulkanDescriptorAllocator.h"
+
+VulkanFrameContext::VulkanFrameContext(std::shared_ptr<VulkanDevice> device_, std::shared_ptr<VulkanInstance> instance_,
+                                       uint32_t threadCount, QueueFamily queueFamily)
+    : device(device_), instance(instance_) {
+    primaryCommandBuffers.commandPool = std::make_shared<VulkanCommandPool>(queueFamily, device, instance, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+
+    threadCommandBuffers.resize(threadCount);
+    for (auto &threadCommandBufferList: threadCommandBuffers)
+        threadCommandBufferList.commandPool = std::make_shared<VulkanCommandPool>(queueFamily, device, instance, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+
+    descriptorAllocator = std::make_shared<VulkanDescriptorAllocator>(device->Handle(), device->GetDeletionQueue());
+}
+
+void VulkanFrameContext::Begin() {
+    primaryCommandBuffers.commandPool->Reset();
+    primaryCommandBuffers.nextCommandBuffer = 0;
+
+    for (auto &threadCommandBufferList: threadCommandBuffers) {
+        threadCommandBufferList.commandPool->Reset();
+        threadCommandBufferList.nextCommandBuffer = 0;
+    }
+
+    descriptorAllocator->ResetPools();
+}
+
+std::shared_ptr<VulkanCommandBuffer> VulkanFrameContext::AllocateCommandBuffer() {
+    return primaryCommandBuffers.Allocate(VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+}
+
+std::shared_ptr<VulkanCommandBuffer> VulkanFrameContext::AllocateSecondaryCommandBuffer(uint32_t threadIndex) {
+    if (threadIndex >= threadCommandBuffers.size()) {
+        throw std::out_of_range("frame context thread index out of range!");
+    }
+
+    return threadCommandBuffers[threadIndex].Allocate(VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+}
+
+uint32_t VulkanFrameContext::GetThreadCount() const {
+    return static_cast<uint32_t>(threadCommandBuffers.size());
+}
+
+std::shared_ptr<VulkanDescriptorAllocator> VulkanFrameContext::GetDescriptorAllocator() {
+    return descriptorAllocator;
+}
+
+std::shared_ptr<VulkanCommandBuffer> VulkanFrameContext::CommandBufferList::Allocate(VkCommandBufferLevel level) {
+    if (nextCommandBuffer == commandBuffers.size())
+        commandBuffers.push_back(commandPool->AllocateBuffer(level));
+
+    return commandBuffers[nextCommandBuffer++];
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "vk_common.h"
+
+// Per frame-in-flight resources. The command pools are transient and reset as a whole once the
+// frame's fence has signaled, so command buffers are recycled instead of being reset or
+// reallocated one by one. Every recording thread gets its own pool, since pools are not thread safe.
+// Descriptor sets that are only needed for one frame are allocated here as well and recycled the same way.
+class VulkanFrameContext {
+    VK_NON_COPIABLE(VulkanFrameContext)
+
+public:
+    VulkanFrameContext(std::shared_ptr<VulkanDevice> device_, std::shared_ptr<VulkanInstance> instance_,
+                       uint32_t threadCount = 0, QueueFamily queueFamily = QueueFamily::Graphics);
+
+    // Must only be called after the GPU has finished executing this frame's previous submission
+    void Begin();
+
+    std::shared_ptr<VulkanCommandBuffer> AllocateCommandBuffer();
+
+    // May be called concurrently as long as every thread uses its own thread index
+    std::shared_ptr<VulkanCommandBuffer> AllocateSecondaryCommandBuffer(uint32_t threadIndex);
+
+    uint32_t GetThreadCount() const;
+
+    // The sets are reset together with the command pools in Begin
+    std::shared_ptr<VulkanDescriptorAllocator> GetDescriptorAllocator();
+
+private:
+    struct CommandBufferList {
+        std::shared_ptr<VulkanCommandPool> commandPool;
+        std::vector<std::shared_ptr<VulkanCommandBuffer>> commandBuffers;
+        size_t nextCommandBuffer = 0;
+
+        std::shared_ptr<VulkanCommandBuffer> Allocate(VkCommandBufferLevel level);
+    };
+
+    std::shared_ptr<VulkanDevice> device;
+    std::shared_ptr<VulkanInstance> instance;
+
+private:
+    CommandBufferList primaryCommandBuffers;
+    std::vector<CommandBufferList> threadCommandBuffers;
+    std::shared_ptr<VulkanDescriptorAllocator> descriptorAllocator;
+};
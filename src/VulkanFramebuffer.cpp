@@ -3,10 +3,17 @@
 #include "VulkanRenderPass.h"
 #include "VulkanSwapChain.h"
 #include "VulkanDevice.h"
+#include "VulkanDeletionQueue.h"
 
 VulkanFramebuffer::VulkanFramebuffer(std::shared_ptr<VulkanDevice> device_, std::shared_ptr<VulkanSwapChain> swapChain_,
                                      std::shared_ptr<VulkanRenderPass> renderPass_, std::vector<std::shared_ptr<VulkanImageView>> attachments)
-    : device(device_), swapChain(swapChain_), renderPass(renderPass_) {
+    : VulkanFramebuffer(device_, renderPass_, attachments, swapChain_->GetExtent()) {
+    swapChain = swapChain_;
+}
+
+VulkanFramebuffer::VulkanFramebuffer(std::shared_ptr<VulkanDevice> device_, std::shared_ptr<VulkanRenderPass> renderPass_,
+                                     std::vector<std::shared_ptr<VulkanImageView>> attachments_, VkExtent2D extent_)
+    : device(device_), renderPass(renderPass_), attachments(attachments_), extent(extent_) {
 
     std::vector<VkImageView> attachmentHandles;
     for (const auto &attachment: attachments)
@@ -17,11 +24,22 @@ VulkanFramebuffer::VulkanFramebuffer(std::shared_ptr<VulkanDevice> device_, std:
     framebufferInfo.renderPass = renderPass->Handle();
     framebufferInfo.attachmentCount = static_cast<uint32_t>(attachmentHandles.size());
     framebufferInfo.pAttachments = attachmentHandles.data();
-    framebufferInfo.width = swapChain->GetExtent().width;
-    framebufferInfo.height = swapChain->GetExtent().height;
+    framebufferInfo.width = extent.width;
+    framebufferInfo.height = extent.height;
     framebufferInfo.layers = 1;
 
     if (vkCreateFramebuffer(device->Handle(), &framebufferInfo, nullptr, &framebuffer) != VK_SUCCESS) {
         throw std::runtime_error("failed to create framebuffer!");
     }
 }
+
+VkExtent2D VulkanFramebuffer::GetExtent() const {
+    return extent;
+}
+
+VulkanFramebuffer::~VulkanFramebuffer() {
+    VkDevice deviceHandle = device->Handle();
+    device->GetDeletionQueue()->Enqueue([deviceHandle, framebuffer = framebuffer]() mutable {
+        VkDestroy(vkDestroyFramebuffer, deviceHandle, framebuffer);
+    });
+}
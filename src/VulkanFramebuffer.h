@@ -9,12 +9,21 @@ public:
     VulkanFramebuffer(std::shared_ptr<VulkanDevice> device_, std::shared_ptr<VulkanSwapChain> swapChain_,
                       std::shared_ptr<VulkanRenderPass> renderPass_, std::vector<std::shared_ptr<VulkanImageView>> attachments);
 
+    VulkanFramebuffer(std::shared_ptr<VulkanDevice> device_, std::shared_ptr<VulkanRenderPass> renderPass_,
+                      std::vector<std::shared_ptr<VulkanImageView>> attachments_, VkExtent2D extent_);
+
+    ~VulkanFramebuffer();
+
+    VkExtent2D GetExtent() const;
+
 private:
     std::shared_ptr<VulkanDevice> device;
     std::shared_ptr<VulkanSwapChain> swapChain;
     std::shared_ptr<VulkanRenderPass> renderPass;
+    std::vector<std::shared_ptr<VulkanImageView>> attachments;
 
 private:
+    VkExtent2D extent;
+
 VK_HANDLE(VkFramebuffer, framebuffer);
 };
-
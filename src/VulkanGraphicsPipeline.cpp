@@ -1,94 +1,288 @@
 #include "VulkanGraphicsPipeline.h"
 
 #include <array>
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <cstring>
 
 #include "VulkanDevice.h"
 #include "VulkanShader.h"
-#include "VulkanSwapChain.h"
 #include "VulkanInstance.h"
 #include "VulkanRenderPass.h"
 #include "VulkanCommandBuffer.h"
+#include "VulkanDeletionQueue.h"
+#include "VulkanPipelineCache.h"
 
-VulkanGraphicsPipeline::VulkanGraphicsPipeline(std::shared_ptr<VulkanShader> vertexShader_, std::shared_ptr<VulkanShader> fragmentShader_,
-                                               std::shared_ptr<VulkanRenderPass> renderPass_, std::shared_ptr<VulkanDevice> device_,
-                                               std::shared_ptr<VulkanSwapChain> swapChain_, VkDescriptorSetLayout descriptorSetLayout_)
-    : device(device_), vertexShader(vertexShader_), fragmentShader(fragmentShader_), swapChain(swapChain_), renderPass(renderPass_), descriptorSetLayout(descriptorSetLayout_) {
+template<typename T>
+static void HashCombine(size_t &seed, const T &value) {
+    seed ^= std::hash<T>()(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+void VulkanSpecializationConstants::Set(uint32_t constantId, uint32_t value) {
+    values[constantId] = value;
+}
+
+void VulkanSpecializationConstants::Set(uint32_t constantId, int32_t value) {
+    Set(constantId, static_cast<uint32_t>(value));
+}
+
+void VulkanSpecializationConstants::Set(uint32_t constantId, float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    Set(constantId, bits);
+}
+
+void VulkanSpecializationConstants::Set(uint32_t constantId, bool value) {
+    Set(constantId, static_cast<uint32_t>(value ? VK_TRUE : VK_FALSE));
+}
+
+bool VulkanSpecializationConstants::IsEmpty() const {
+    return values.empty();
+}
+
+bool VulkanSpecializationConstants::operator==(const VulkanSpecializationConstants &other) const {
+    return values == other.values;
+}
+
+size_t VulkanDescriptorSetLayoutDescription::Hash() const {
+    size_t seed = 0;
+    HashCombine(seed, flags);
+    for (const auto &binding: bindings) {
+        HashCombine(seed, binding.binding);
+        HashCombine(seed, static_cast<uint32_t>(binding.descriptorType));
+        HashCombine(seed, binding.descriptorCount);
+        HashCombine(seed, binding.stageFlags);
+    }
+    for (auto bindingFlag: bindingFlags)
+        HashCombine(seed, bindingFlag);
+
+    return seed;
+}
+
+bool VulkanDescriptorSetLayoutDescription::operator==(const VulkanDescriptorSetLayoutDescription &other) const {
+    auto isBindingEqual = [](const VkDescriptorSetLayoutBinding &a, const VkDescriptorSetLayoutBinding &b) {
+        return a.binding == b.binding && a.descriptorType == b.descriptorType && a.descriptorCount == b.descriptorCount &&
+               a.stageFlags == b.stageFlags && a.pImmutableSamplers == b.pImmutableSamplers;
+    };
+
+    return flags == other.flags && bindingFlags == other.bindingFlags &&
+           std::equal(bindings.begin(), bindings.end(), other.bindings.begin(), other.bindings.end(), isBindingEqual);
+}
+
+// Lays the values out one after the other, the entries and data have to outlive the returned info
+static VkSpecializationInfo BuildSpecializationInfo(std::shared_ptr<VulkanShader> shader, const VulkanSpecializationConstants &constants,
+                                                    std::vector<VkSpecializationMapEntry> &entries, std::vector<uint32_t> &data) {
+    const auto &declaredIds = shader->GetReflection().specializationConstantIds;
+    for (const auto &[constantId, value]: constants.values) {
+        if (std::find(declaredIds.begin(), declaredIds.end(), constantId) == declaredIds.end()) {
+            throw std::runtime_error("shader declares no specialization constant with id " + std::to_string(constantId) + "!");
+        }
+
+        VkSpecializationMapEntry entry{};
+        entry.constantID = constantId;
+        entry.offset = static_cast<uint32_t>(data.size() * sizeof(uint32_t));
+        entry.size = sizeof(uint32_t);
+        entries.push_back(entry);
+        data.push_back(value);
+    }
+
+    VkSpecializationInfo specializationInfo{};
+    specializationInfo.mapEntryCount = static_cast<uint32_t>(entries.size());
+    specializationInfo.pMapEntries = entries.data();
+    specializationInfo.dataSize = data.size() * sizeof(uint32_t);
+    specializationInfo.pData = data.data();
+    return specializationInfo;
+}
+
+VulkanGraphicsPipelineState::VulkanGraphicsPipelineState() {
+    auto attributeDescriptions = Vertex::getAttributeDescriptions();
+    vertexBindings = {Vertex::getBindingDescription()};
+    vertexAttributes.assign(attributeDescriptions.begin(), attributeDescriptions.end());
+}
+
+size_t VulkanGraphicsPipelineState::Hash() const {
+    size_t seed = 0;
+    HashCombine(seed, vertexShader.get());
+    HashCombine(seed, fragmentShader.get());
+    HashCombine(seed, renderPass != nullptr ? renderPass->GetCompatibilityHash() : 0);
+    HashCombine(seed, subpass);
+    for (const auto &descriptorSetLayout: descriptorSetLayouts)
+        HashCombine(seed, descriptorSetLayout.Hash());
+
+    for (const auto *specialization: {&vertexSpecialization, &fragmentSpecialization}) {
+        HashCombine(seed, specialization->values.size());
+        for (const auto &[constantId, value]: specialization->values) {
+            HashCombine(seed, constantId);
+            HashCombine(seed, value);
+        }
+    }
+
+    for (const auto &binding: vertexBindings) {
+        HashCombine(seed, binding.binding);
+        HashCombine(seed, binding.stride);
+        HashCombine(seed, static_cast<uint32_t>(binding.inputRate));
+    }
+    for (const auto &attribute: vertexAttributes) {
+        HashCombine(seed, attribute.location);
+        HashCombine(seed, attribute.binding);
+        HashCombine(seed, static_cast<uint32_t>(attribute.format));
+        HashCombine(seed, attribute.offset);
+    }
+    HashCombine(seed, static_cast<uint32_t>(topology));
+
+    HashCombine(seed, static_cast<uint32_t>(polygonMode));
+    HashCombine(seed, cullMode);
+    HashCombine(seed, static_cast<uint32_t>(frontFace));
+
+    HashCombine(seed, depthTestEnable);
+    HashCombine(seed, depthWriteEnable);
+    HashCombine(seed, static_cast<uint32_t>(depthCompareOp));
+
+    // The blend factors are ignored while blending is disabled, so they must not split the variants either
+    HashCombine(seed, blendEnable);
+    if (blendEnable) {
+        HashCombine(seed, static_cast<uint32_t>(srcColorBlendFactor));
+        HashCombine(seed, static_cast<uint32_t>(dstColorBlendFactor));
+        HashCombine(seed, static_cast<uint32_t>(colorBlendOp));
+        HashCombine(seed, static_cast<uint32_t>(srcAlphaBlendFactor));
+        HashCombine(seed, static_cast<uint32_t>(dstAlphaBlendFactor));
+        HashCombine(seed, static_cast<uint32_t>(alphaBlendOp));
+    }
+
+    return seed;
+}
+
+bool VulkanGraphicsPipelineState::operator==(const VulkanGraphicsPipelineState &other) const {
+    bool isRenderPassCompatible = renderPass == other.renderPass ||
+                                  (renderPass != nullptr && other.renderPass != nullptr && renderPass->IsCompatibleWith(*other.renderPass));
+    bool isBlendEqual = blendEnable == other.blendEnable &&
+                        (!blendEnable || (srcColorBlendFactor == other.srcColorBlendFactor && dstColorBlendFactor == other.dstColorBlendFactor &&
+                                          colorBlendOp == other.colorBlendOp && srcAlphaBlendFactor == other.srcAlphaBlendFactor &&
+                                          dstAlphaBlendFactor == other.dstAlphaBlendFactor && alphaBlendOp == other.alphaBlendOp));
+
+    auto isBindingEqual = [](const VkVertexInputBindingDescription &a, const VkVertexInputBindingDescription &b) {
+        return a.binding == b.binding && a.stride == b.stride && a.inputRate == b.inputRate;
+    };
+    auto isAttributeEqual = [](const VkVertexInputAttributeDescription &a, const VkVertexInputAttributeDescription &b) {
+        return a.location == b.location && a.binding == b.binding && a.format == b.format && a.offset == b.offset;
+    };
+
+    return vertexShader == other.vertexShader && fragmentShader == other.fragmentShader && isRenderPassCompatible && subpass == other.subpass &&
+           descriptorSetLayouts == other.descriptorSetLayouts &&
+           vertexSpecialization == other.vertexSpecialization && fragmentSpecialization == other.fragmentSpecialization &&
+           std::equal(vertexBindings.begin(), vertexBindings.end(), other.vertexBindings.begin(), other.vertexBindings.end(), isBindingEqual) &&
+           std::equal(vertexAttributes.begin(), vertexAttributes.end(), other.vertexAttributes.begin(), other.vertexAttributes.end(), isAttributeEqual) &&
+           topology == other.topology && polygonMode == other.polygonMode && cullMode == other.cullMode && frontFace == other.frontFace &&
+           depthTestEnable == other.depthTestEnable && depthWriteEnable == other.depthWriteEnable && depthCompareOp == other.depthCompareOp &&
+           isBlendEqual;
+}
+
+VulkanGraphicsPipeline::VulkanGraphicsPipeline(std::shared_ptr<VulkanDevice> device_, const VulkanGraphicsPipelineState &state_)
+    : device(device_), state(state_) {
+    if (state.vertexShader == nullptr || state.fragmentShader == nullptr || state.renderPass == nullptr) {
+        throw std::invalid_argument("graphics pipeline state is missing a shader or the render pass!");
+    }
+
+    // Every input the vertex shader reads has to be fed by an attribute of the same format
+    for (const auto &input: state.vertexShader->GetReflection().vertexInputs) {
+        auto attribute = std::find_if(state.vertexAttributes.begin(), state.vertexAttributes.end(), [&](const VkVertexInputAttributeDescription &description) {
+            return description.location == input.location;
+        });
+
+        if (attribute == state.vertexAttributes.end()) {
+            throw std::runtime_error("vertex shader input " + input.name + " has no vertex attribute!");
+        }
+        if (input.format != VK_FORMAT_UNDEFINED && attribute->format != input.format) {
+            throw std::runtime_error("vertex attribute format does not match vertex shader input " + input.name + "!");
+        }
+    }
 
     VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
     vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
     vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
-    vertShaderStageInfo.module = vertexShader->Handle();
+    vertShaderStageInfo.module = state.vertexShader->Handle();
     vertShaderStageInfo.pName = "main";
 
+    std::vector<VkSpecializationMapEntry> vertexSpecializationEntries;
+    std::vector<uint32_t> vertexSpecializationData;
+    auto vertexSpecializationInfo = BuildSpecializationInfo(state.vertexShader, state.vertexSpecialization,
+                                                            vertexSpecializationEntries, vertexSpecializationData);
+    if (!state.vertexSpecialization.IsEmpty())
+        vertShaderStageInfo.pSpecializationInfo = &vertexSpecializationInfo;
+
     VkPipelineShaderStageCreateInfo fragShaderStageInfo{};
     fragShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
     fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-    fragShaderStageInfo.module = fragmentShader->Handle();
+    fragShaderStageInfo.module = state.fragmentShader->Handle();
     fragShaderStageInfo.pName = "main";
 
+    std::vector<VkSpecializationMapEntry> fragmentSpecializationEntries;
+    std::vector<uint32_t> fragmentSpecializationData;
+    auto fragmentSpecializationInfo = BuildSpecializationInfo(state.fragmentShader, state.fragmentSpecialization,
+                                                              fragmentSpecializationEntries, fragmentSpecializationData);
+    if (!state.fragmentSpecialization.IsEmpty())
+        fragShaderStageInfo.pSpecializationInfo = &fragmentSpecializationInfo;
+
     VkPipelineShaderStageCreateInfo shaderStages[] = {vertShaderStageInfo, fragShaderStageInfo};
 
     VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
     vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 
-    auto bindingDescription = Vertex::getBindingDescription();
-    auto attributeDescriptions = Vertex::getAttributeDescriptions();
-
-    vertexInputInfo.vertexBindingDescriptionCount = 1;
-    vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
-    vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
-    vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
+    vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(state.vertexBindings.size());
+    vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(state.vertexAttributes.size());
+    vertexInputInfo.pVertexBindingDescriptions = state.vertexBindings.data();
+    vertexInputInfo.pVertexAttributeDescriptions = state.vertexAttributes.data();
 
     VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
     inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-    inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    inputAssembly.topology = state.topology;
     inputAssembly.primitiveRestartEnable = VK_FALSE;
 
-    VkViewport viewport{};
-    viewport.x = 0.0f;
-    viewport.y = 0.0f;
-    viewport.width = (float) swapChain->GetExtent().width;
-    viewport.height = (float) swapChain->GetExtent().height;
-    viewport.minDepth = 0.0f;
-    viewport.maxDepth = 1.0f;
-
-    VkRect2D scissor{};
-    scissor.offset = {0, 0};
-    scissor.extent = swapChain->GetExtent();
-
+    // The viewport and scissor rectangles are set at record time, so the pipeline survives swap chain resizes
     VkPipelineViewportStateCreateInfo viewportState{};
     viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
     viewportState.viewportCount = 1;
-    viewportState.pViewports = &viewport;
     viewportState.scissorCount = 1;
-    viewportState.pScissors = &scissor;
+
+    std::array<VkDynamicState, 2> dynamicStates = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+    VkPipelineDynamicStateCreateInfo dynamicState{};
+    dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
+    dynamicState.pDynamicStates = dynamicStates.data();
 
     VkPipelineRasterizationStateCreateInfo rasterizer{};
     rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
     rasterizer.depthClampEnable = VK_FALSE;
     rasterizer.rasterizerDiscardEnable = VK_FALSE;
-    rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+    rasterizer.polygonMode = state.polygonMode;
     rasterizer.lineWidth = 1.0f;
-    rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
-    rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+    rasterizer.cullMode = state.cullMode;
+    rasterizer.frontFace = state.frontFace;
     rasterizer.depthBiasEnable = VK_FALSE;
 
     VkPipelineMultisampleStateCreateInfo multisampling{};
     multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
     multisampling.sampleShadingEnable = VK_FALSE;
-    multisampling.rasterizationSamples = VulkanInstance::MsaaSamples;
+    multisampling.rasterizationSamples = state.renderPass->GetSampleCount();
 
     VkPipelineDepthStencilStateCreateInfo depthStencil{};
     depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-    depthStencil.depthTestEnable = VK_TRUE;
-    depthStencil.depthWriteEnable = VK_TRUE;
-    depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
+    depthStencil.depthTestEnable = state.depthTestEnable ? VK_TRUE : VK_FALSE;
+    depthStencil.depthWriteEnable = state.depthWriteEnable ? VK_TRUE : VK_FALSE;
+    depthStencil.depthCompareOp = state.depthCompareOp;
     depthStencil.depthBoundsTestEnable = VK_FALSE;
     depthStencil.stencilTestEnable = VK_FALSE;
 
     VkPipelineColorBlendAttachmentState colorBlendAttachment{};
     colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-    colorBlendAttachment.blendEnable = VK_FALSE;
+    colorBlendAttachment.blendEnable = state.blendEnable ? VK_TRUE : VK_FALSE;
+    colorBlendAttachment.srcColorBlendFactor = state.srcColorBlendFactor;
+    colorBlendAttachment.dstColorBlendFactor = state.dstColorBlendFactor;
+    colorBlendAttachment.colorBlendOp = state.colorBlendOp;
+    colorBlendAttachment.srcAlphaBlendFactor = state.srcAlphaBlendFactor;
+    colorBlendAttachment.dstAlphaBlendFactor = state.dstAlphaBlendFactor;
+    colorBlendAttachment.alphaBlendOp = state.alphaBlendOp;
 
     VkPipelineColorBlendStateCreateInfo colorBlending{};
     colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
@@ -103,8 +297,16 @@ VulkanGraphicsPipeline::VulkanGraphicsPipeline(std::shared_ptr<VulkanShader> ver
 
     VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
     pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipelineLayoutInfo.setLayoutCount = 1;
-    pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
+    std::vector<VkDescriptorSetLayout> setLayouts;
+    for (const auto &descriptorSetLayout: state.descriptorSetLayouts)
+        setLayouts.push_back(descriptorSetLayout.layout);
+
+    pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+    pipelineLayoutInfo.pSetLayouts = setLayouts.data();
+
+    pushConstantRanges = VulkanShader::MergePushConstantRanges({state.vertexShader, state.fragmentShader});
+    pipelineLayoutInfo.pushConstantRangeCount = static_cast<uint32_t>(pushConstantRanges.size());
+    pipelineLayoutInfo.pPushConstantRanges = pushConstantRanges.data();
 
     if (vkCreatePipelineLayout(device->Handle(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
         throw std::runtime_error("failed to create pipeline layout!");
@@ -121,23 +323,61 @@ VulkanGraphicsPipeline::VulkanGraphicsPipeline(std::shared_ptr<VulkanShader> ver
     pipelineInfo.pMultisampleState = &multisampling;
     pipelineInfo.pDepthStencilState = &depthStencil;
     pipelineInfo.pColorBlendState = &colorBlending;
+    pipelineInfo.pDynamicState = &dynamicState;
     pipelineInfo.layout = pipelineLayout;
-    pipelineInfo.renderPass = renderPass->Handle();
-    pipelineInfo.subpass = 0;
+    pipelineInfo.renderPass = state.renderPass->Handle();
+    pipelineInfo.subpass = state.subpass;
     pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
-    if (vkCreateGraphicsPipelines(device->Handle(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
+    if (vkCreateGraphicsPipelines(device->Handle(), device->GetPipelineCache()->Handle(), 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
+        VkDestroy(vkDestroyPipelineLayout, device->Handle(), pipelineLayout);
         throw std::runtime_error("failed to create graphics pipeline!");
     }
+}
 
-    vkDestroyShaderModule(device->Handle(), fragmentShader->Handle(), nullptr);
-    vkDestroyShaderModule(device->Handle(), vertexShader->Handle(), nullptr);
+VulkanGraphicsPipeline::VulkanGraphicsPipeline(std::shared_ptr<VulkanShader> vertexShader_, std::shared_ptr<VulkanShader> fragmentShader_,
+                                               std::shared_ptr<VulkanRenderPass> renderPass_, std::shared_ptr<VulkanDevice> device_,
+                                               const VulkanDescriptorSetLayoutDescription &descriptorSetLayout_)
+    : VulkanGraphicsPipeline(device_, [&]() {
+    VulkanGraphicsPipelineState defaultState;
+    defaultState.vertexShader = vertexShader_;
+    defaultState.fragmentShader = fragmentShader_;
+    defaultState.renderPass = renderPass_;
+    defaultState.descriptorSetLayouts = {descriptorSetLayout_};
+    return defaultState;
+}()) {
 }
 
 VkPipelineLayout VulkanGraphicsPipeline::GetPipelineLayout() {
     return pipelineLayout;
 }
 
+std::shared_ptr<VulkanRenderPass> VulkanGraphicsPipeline::GetRenderPass() {
+    return state.renderPass;
+}
+
+const VulkanGraphicsPipelineState &VulkanGraphicsPipeline::GetState() const {
+    return state;
+}
+
+VkShaderStageFlags VulkanGraphicsPipeline::GetPushConstantStages(uint32_t offset, uint32_t size) const {
+    VkShaderStageFlags stages = 0;
+    for (const auto &range: pushConstantRanges) {
+        if (offset < range.offset + range.size && range.offset < offset + size)
+            stages |= range.stageFlags;
+    }
+
+    return stages;
+}
+
 void VulkanGraphicsPipeline::Bind(std::shared_ptr<VulkanCommandBuffer> commandBuffer) {
     vkCmdBindPipeline(commandBuffer->Handle(), VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
 }
+
+VulkanGraphicsPipeline::~VulkanGraphicsPipeline() {
+    VkDevice deviceHandle = device->Handle();
+    device->GetDeletionQueue()->Enqueue([deviceHandle, graphicsPipeline = graphicsPipeline, pipelineLayout = pipelineLayout]() mutable {
+        VkDestroy(vkDestroyPipeline, deviceHandle, graphicsPipeline);
+        VkDestroy(vkDestroyPipelineLayout, deviceHandle, pipelineLayout);
+    });
+}
@@ -1,30 +1,110 @@
 #pragma once
 
+#include <map>
+
 #include "vk_common.h"
 
+// Values for the specialization constants of one shader stage, keyed by constant id. Every constant is 32 bits
+// wide, which covers the bool, int, uint and float constants GLSL can declare.
+struct VulkanSpecializationConstants {
+    std::map<uint32_t, uint32_t> values;
+
+    void Set(uint32_t constantId, uint32_t value);
+    void Set(uint32_t constantId, int32_t value);
+    void Set(uint32_t constantId, float value);
+    void Set(uint32_t constantId, bool value);
+
+    bool IsEmpty() const;
+
+    bool operator==(const VulkanSpecializationConstants &other) const;
+};
+
+// A descriptor set layout and the definition it was created from. Identically defined layouts are compatible,
+// so pipeline states compare the definition. The handle isn't compared because Vulkan may reuse it once the layout is destroyed.
+struct VulkanDescriptorSetLayoutDescription {
+    VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+    VkDescriptorSetLayoutCreateFlags flags = 0;
+    std::vector<VkDescriptorSetLayoutBinding> bindings;
+    std::vector<VkDescriptorBindingFlags> bindingFlags;
+
+    size_t Hash() const;
+
+    bool operator==(const VulkanDescriptorSetLayoutDescription &other) const;
+};
+
+// Everything a graphics pipeline is built from. Two states that compare equal produce interchangeable
+// pipelines, the render pass only has to be compatible, not the same object.
+struct VulkanGraphicsPipelineState {
+    std::shared_ptr<VulkanShader> vertexShader;
+    std::shared_ptr<VulkanShader> fragmentShader;
+    std::shared_ptr<VulkanRenderPass> renderPass;
+    uint32_t subpass = 0;
+    // Ordered by update frequency, set 0 changes least often. The index in the vector is the set index in the shaders.
+    std::vector<VulkanDescriptorSetLayoutDescription> descriptorSetLayouts;
+
+    // Each set of values produces its own constant-folded variant of the shader
+    VulkanSpecializationConstants vertexSpecialization;
+    VulkanSpecializationConstants fragmentSpecialization;
+
+    std::vector<VkVertexInputBindingDescription> vertexBindings;
+    std::vector<VkVertexInputAttributeDescription> vertexAttributes;
+    VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+    VkPolygonMode polygonMode = VK_POLYGON_MODE_FILL;
+    VkCullModeFlags cullMode = VK_CULL_MODE_BACK_BIT;
+    VkFrontFace frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+
+    bool depthTestEnable = true;
+    bool depthWriteEnable = true;
+    VkCompareOp depthCompareOp = VK_COMPARE_OP_LESS;
+
+    bool blendEnable = false;
+    VkBlendFactor srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+    VkBlendFactor dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    VkBlendOp colorBlendOp = VK_BLEND_OP_ADD;
+    VkBlendFactor srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+    VkBlendFactor dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+    VkBlendOp alphaBlendOp = VK_BLEND_OP_ADD;
+
+    // Uses the vertex layout of the Vertex structure
+    VulkanGraphicsPipelineState();
+
+    size_t Hash() const;
+
+    bool operator==(const VulkanGraphicsPipelineState &other) const;
+};
+
 class VulkanGraphicsPipeline {
     VK_NON_COPIABLE(VulkanGraphicsPipeline)
 
 public:
+    VulkanGraphicsPipeline(std::shared_ptr<VulkanDevice> device_, const VulkanGraphicsPipelineState &state_);
+
     VulkanGraphicsPipeline(std::shared_ptr<VulkanShader> vertexShader_, std::shared_ptr<VulkanShader> fragmentShader_,
                            std::shared_ptr<VulkanRenderPass> renderPass_, std::shared_ptr<VulkanDevice> device_,
-                           std::shared_ptr<VulkanSwapChain> swapChain_, VkDescriptorSetLayout descriptorSetLayout);
+                           const VulkanDescriptorSetLayoutDescription &descriptorSetLayout);
+
+    ~VulkanGraphicsPipeline();
 
     VkPipelineLayout GetPipelineLayout();
 
+    std::shared_ptr<VulkanRenderPass> GetRenderPass();
+
+    const VulkanGraphicsPipelineState &GetState() const;
+
+    // Union of the stages whose push constant ranges overlap the given bytes, as vkCmdPushConstants expects them
+    VkShaderStageFlags GetPushConstantStages(uint32_t offset, uint32_t size) const;
+
+    // Viewport and scissor are dynamic state, they have to be set on every command buffer the pipeline is bound in
     void Bind(std::shared_ptr<VulkanCommandBuffer> commandBuffer);
 
 private:
     std::shared_ptr<VulkanDevice> device;
-    std::shared_ptr<VulkanShader> vertexShader;
-    std::shared_ptr<VulkanShader> fragmentShader;
-    std::shared_ptr<VulkanSwapChain> swapChain;
-    std::shared_ptr<VulkanRenderPass> renderPass;
+    VulkanGraphicsPipelineState state;
+    std::vector<VkPushConstantRange> pushConstantRanges;
 
 private:
-    VkDescriptorSetLayout descriptorSetLayout;
     VkPipelineLayout pipelineLayout;
 
 VK_HANDLE(VkPipeline, graphicsPipeline);
 };
-
@@ -6,11 +6,16 @@
 #include "VulkanBuffer.h"
 #include "VulkanCommandBuffer.h"
 #include "VulkanTextureSampler.h"
+#include "VulkanUploadContext.h"
+#include "VulkanDeletionQueue.h"
+#include "VulkanBarrierBatcher.h"
 
 #include "lib_common.h"
 
 VulkanImage::VulkanImage(VkImage image_, std::shared_ptr<VulkanDevice> device_) : image(image_), device(device_), mipLevels(1) {
-
+    ownsImage = false;
+    ownsMemory = false;
+    subresourceStates.resize(1);
 }
 
 VulkanImage::VulkanImage(std::shared_ptr<VulkanInstance> instance_, std::shared_ptr<VulkanDevice> device_,
@@ -27,8 +32,42 @@ VulkanImage::VulkanImage(std::shared_ptr<VulkanInstance> instance_, std::shared_
     CreateImageInternal(width, height, numSamples, format, tiling, usage, properties, mipLevels);
 }
 
+VulkanImage::VulkanImage(std::shared_ptr<VulkanInstance> instance_, std::shared_ptr<VulkanDevice> device_,
+                         uint32_t width_, uint32_t height_, VkSampleCountFlagBits numSamples, VkFormat format_, VkImageUsageFlags usage)
+    : device(device_), format(format_), width(width_), height(height_), instance(instance_), mipLevels(1) {
+    ownsMemory = false;
+    CreateImageHandle(width, height, numSamples, format, VK_IMAGE_TILING_OPTIMAL, usage, mipLevels);
+}
+
+VulkanImage::~VulkanImage() {
+    if (!ownsImage)
+        return;
+
+    VkDevice deviceHandle = device->Handle();
+    auto memoryAllocator = device->GetMemoryAllocator();
+    device->GetDeletionQueue()->Enqueue([deviceHandle, memoryAllocator, image = image, allocation = allocation, ownsMemory = ownsMemory]() mutable {
+        VkDestroy(vkDestroyImage, deviceHandle, image);
+        if (ownsMemory)
+            memoryAllocator->Free(allocation);
+    });
+}
+
+VkMemoryRequirements VulkanImage::GetMemoryRequirements() {
+    VkMemoryRequirements memRequirements;
+    vkGetImageMemoryRequirements(device->Handle(), image, &memRequirements);
+    return memRequirements;
+}
+
+void VulkanImage::BindMemory(VkDeviceMemory memory, VkDeviceSize offset) {
+    if (ownsMemory) {
+        throw std::runtime_error("image already owns its memory!");
+    }
+
+    vkBindImageMemory(device->Handle(), image, memory, offset);
+}
+
 std::shared_ptr<VulkanImage> VulkanImage::LoadFrom(const char *path, std::shared_ptr<VulkanInstance> instance, std::shared_ptr<VulkanDevice> device,
-                                                   std::shared_ptr<VulkanCommandPool> commandPool) {
+                                                   std::shared_ptr<VulkanUploadContext> uploadContext) {
 
     int texWidth, texHeight, texChannels;
     stbi_uc *pixels = stbi_load(path, &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
@@ -38,22 +77,14 @@ std::shared_ptr<VulkanImage> VulkanImage::LoadFrom(const char *path, std::shared
         throw std::runtime_error("failed to load texture image!");
     }
 
-    auto stagingBuffer = std::make_shared<VulkanBuffer>(device, instance, imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                                                        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-    stagingBuffer->CopyFrom(pixels, static_cast<size_t>(imageSize));
-    stbi_image_free(pixels);
-
     auto textureImage = std::make_shared<VulkanImage>(instance, device, texWidth, texHeight, VK_SAMPLE_COUNT_1_BIT, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL,
                                                       VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
                                                       VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
 
-    auto commandBuffer = commandPool->AllocateBuffer()->Begin(true);
-    textureImage->ChangeLayout(commandBuffer, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-    commandBuffer->EndAndSubmit();
-
-    stagingBuffer->CopyTo(commandPool, textureImage);
+    // The pixels are copied into the staging arena right away, the GPU side work is deferred to the next batch submit
+    uploadContext->UploadImage(textureImage, pixels, imageSize);
+    stbi_image_free(pixels);
 
-    textureImage->GenerateMipMaps(commandPool);
     return textureImage;
 }
 
@@ -61,8 +92,10 @@ std::shared_ptr<VulkanImageView> VulkanImage::GetView(VkFormat format, VkImageAs
     std::hash<uint32_t> uint_hash;
     auto viewHash = uint_hash((uint32_t) format) + 0x9e3779b9 + uint_hash((uint32_t) aspectFlags) + 0x9e3779b1 + uint_hash(mipLevels);
     auto match = imageViewCache.find(viewHash);
-    if (match != imageViewCache.end())
-        return match->second;
+    if (match != imageViewCache.end()) {
+        if (auto cachedView = match->second.lock())
+            return cachedView;
+    }
 
     VkImageViewCreateInfo viewInfo{};
     viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -80,67 +113,72 @@ std::shared_ptr<VulkanImageView> VulkanImage::GetView(VkFormat format, VkImageAs
         throw std::runtime_error("failed to create texture image view!");
     }
 
-    auto imageView = std::make_shared<VulkanImageView>(imageViewHandle, this->shared_from_this());
+    auto imageView = std::make_shared<VulkanImageView>(imageViewHandle, this->shared_from_this(), device);
     imageViewCache[viewHash] = imageView;
 
     return imageView;
 }
 
-uint32_t VulkanImage::FindMemoryType(std::shared_ptr<VulkanInstance> instance, uint32_t typeFilter, VkMemoryPropertyFlags properties) {
-    VkPhysicalDeviceMemoryProperties memProperties;
-    vkGetPhysicalDeviceMemoryProperties(instance->PhysicalDeviceHandle(), &memProperties);
+void VulkanImage::ChangeLayout(std::shared_ptr<VulkanCommandBuffer> commandBuffer, VkImageLayout newLayout, VkPipelineStageFlags2 stages, VkAccessFlags2 accessMask) {
+    VulkanBarrierBatcher barriers(commandBuffer);
+    barriers.Transition(shared_from_this(), newLayout, stages, accessMask);
+    barriers.Flush();
+}
 
-    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
-        if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
-            return i;
-        }
-    }
+void VulkanImage::GetSize(uint32_t &width_, uint32_t &height_) {
+    width_ = width;
+    height_ = height;
+}
 
-    throw std::runtime_error("failed to find suitable memory type!");
+uint32_t VulkanImage::GetMipLevels() const {
+    return mipLevels;
 }
 
-void VulkanImage::ChangeLayout(std::shared_ptr<VulkanCommandBuffer> commandBuffer, VkImageLayout oldLayout, VkImageLayout newLayout) {
-    VkImageMemoryBarrier barrier{};
-    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-    barrier.oldLayout = oldLayout;
-    barrier.newLayout = newLayout;
-    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.image = image;
-    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    barrier.subresourceRange.baseMipLevel = 0;
-    barrier.subresourceRange.levelCount = mipLevels;
-    barrier.subresourceRange.baseArrayLayer = 0;
-    barrier.subresourceRange.layerCount = 1;
-
-    VkPipelineStageFlags sourceStage;
-    VkPipelineStageFlags destinationStage;
-
-    if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
-        barrier.srcAccessMask = 0;
-        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-
-        sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-        destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-    } else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
-        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-        sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-        destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-    } else {
-        throw std::invalid_argument("unsupported layout transition!");
+uint32_t VulkanImage::GetArrayLayers() const {
+    return arrayLayers;
+}
+
+VkImageAspectFlags VulkanImage::GetAspectMask() const {
+    switch (format) {
+        case VK_FORMAT_D16_UNORM:
+        case VK_FORMAT_D32_SFLOAT:
+            return VK_IMAGE_ASPECT_DEPTH_BIT;
+        case VK_FORMAT_D16_UNORM_S8_UINT:
+        case VK_FORMAT_D24_UNORM_S8_UINT:
+        case VK_FORMAT_D32_SFLOAT_S8_UINT:
+            return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+        case VK_FORMAT_S8_UINT:
+            return VK_IMAGE_ASPECT_STENCIL_BIT;
+        default:
+            return VK_IMAGE_ASPECT_COLOR_BIT;
     }
+}
 
-    vkCmdPipelineBarrier(commandBuffer->Handle(), sourceStage, destinationStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+VulkanImageState VulkanImage::GetSubresourceState(uint32_t mipLevel, uint32_t arrayLayer) const {
+    return subresourceStates.at(arrayLayer * mipLevels + mipLevel);
 }
 
-void VulkanImage::GetSize(uint32_t &width_, uint32_t &height_) {
-    width_ = width;
-    height_ = height;
+void VulkanImage::SetSubresourceState(uint32_t mipLevel, uint32_t arrayLayer, const VulkanImageState &state) {
+    subresourceStates.at(arrayLayer * mipLevels + mipLevel) = state;
+}
+
+VkFormat VulkanImage::GetFormat() const {
+    return format;
 }
 
 void VulkanImage::GenerateMipMaps(std::shared_ptr<VulkanCommandPool> commandPool) {
+    auto commandBuffer = commandPool->AllocateBuffer()->Begin(true);
+    GenerateMipMaps(commandBuffer);
+    commandBuffer->EndAndSubmit();
+}
+
+void VulkanImage::GenerateMipMaps(std::shared_ptr<VulkanCommandBuffer> commandBuffer) {
+    VulkanBarrierBatcher barriers(commandBuffer);
+    GenerateMipMaps(barriers);
+    barriers.Flush();
+}
+
+void VulkanImage::GenerateMipMaps(VulkanBarrierBatcher &barriers) {
     // Check if image format supports linear blitting
     VkFormatProperties formatProperties;
     vkGetPhysicalDeviceFormatProperties(instance->PhysicalDeviceHandle(), format, &formatProperties);
@@ -149,33 +187,17 @@ void VulkanImage::GenerateMipMaps(std::shared_ptr<VulkanCommandPool> commandPool
         throw std::runtime_error("texture image format does not support linear blitting!");
     }
 
-    auto commandBuffer = commandPool->AllocateBuffer()->Begin(true);
-
-    VkImageMemoryBarrier barrier{};
-    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-    barrier.image = image;
-    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    barrier.subresourceRange.baseArrayLayer = 0;
-    barrier.subresourceRange.layerCount = 1;
-    barrier.subresourceRange.levelCount = 1;
+    auto commandBuffer = barriers.GetCommandBuffer();
+    auto self = shared_from_this();
 
     int32_t mipWidth = width;
     int32_t mipHeight = height;
 
     for (uint32_t i = 1; i < mipLevels; i++) {
-        barrier.subresourceRange.baseMipLevel = i - 1;
-        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-
-        vkCmdPipelineBarrier(commandBuffer->Handle(),
-                             VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
-                             0, nullptr,
-                             0, nullptr,
-                             1, &barrier);
+        // Every level is blitted from the previous one, so this barrier can't be merged with the others
+        barriers.Transition(self, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_PIPELINE_STAGE_2_BLIT_BIT, VK_ACCESS_2_TRANSFER_READ_BIT, i - 1, 1);
+        barriers.Transition(self, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_2_BLIT_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, i, 1);
+        barriers.Flush();
 
         VkImageBlit blit{};
         blit.srcOffsets[0] = {0, 0, 0};
@@ -197,38 +219,29 @@ void VulkanImage::GenerateMipMaps(std::shared_ptr<VulkanCommandPool> commandPool
                        1, &blit,
                        VK_FILTER_LINEAR);
 
-        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-        vkCmdPipelineBarrier(commandBuffer->Handle(),
-                             VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
-                             0, nullptr,
-                             0, nullptr,
-                             1, &barrier);
-
         if (mipWidth > 1) mipWidth /= 2;
         if (mipHeight > 1) mipHeight /= 2;
     }
 
-    barrier.subresourceRange.baseMipLevel = mipLevels - 1;
-    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-    vkCmdPipelineBarrier(commandBuffer->Handle(),
-                         VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
-                         0, nullptr,
-                         0, nullptr,
-                         1, &barrier);
-
-    commandBuffer->EndAndSubmit();
+    // One barrier for the source levels and one for the last level, both recorded with the caller's next flush
+    barriers.Transition(self, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_READ_BIT);
 }
 
 void VulkanImage::CreateImageInternal(uint32_t width_, uint32_t height_, VkSampleCountFlagBits numSamples, VkFormat format_,
                                       VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, int mipLevels_) {
+    CreateImageHandle(width_, height_, numSamples, format_, tiling, usage, mipLevels_);
+
+    VkMemoryRequirements memRequirements = GetMemoryRequirements();
+
+    VulkanMemoryCategory category = (usage & (VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT))
+                                    ? VulkanMemoryCategory::Attachment : VulkanMemoryCategory::Image;
+    allocation = device->GetMemoryAllocator()->Allocate(memRequirements, properties, 0, tiling == VK_IMAGE_TILING_LINEAR, category);
+
+    vkBindImageMemory(device->Handle(), image, allocation.memory, allocation.offset);
+}
+
+void VulkanImage::CreateImageHandle(uint32_t width_, uint32_t height_, VkSampleCountFlagBits numSamples, VkFormat format_,
+                                    VkImageTiling tiling, VkImageUsageFlags usage, int mipLevels_) {
     VkImageCreateInfo imageInfo{};
     imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
     imageInfo.imageType = VK_IMAGE_TYPE_2D;
@@ -236,7 +249,7 @@ void VulkanImage::CreateImageInternal(uint32_t width_, uint32_t height_, VkSampl
     imageInfo.extent.height = height_;
     imageInfo.extent.depth = 1;
     imageInfo.mipLevels = mipLevels_;
-    imageInfo.arrayLayers = 1;
+    imageInfo.arrayLayers = arrayLayers;
     imageInfo.format = format_;
     imageInfo.tiling = tiling;
     imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
@@ -248,17 +261,5 @@ void VulkanImage::CreateImageInternal(uint32_t width_, uint32_t height_, VkSampl
         throw std::runtime_error("failed to create image!");
     }
 
-    VkMemoryRequirements memRequirements;
-    vkGetImageMemoryRequirements(device->Handle(), image, &memRequirements);
-
-    VkMemoryAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = FindMemoryType(instance, memRequirements.memoryTypeBits, properties);
-
-    if (vkAllocateMemory(device->Handle(), &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
-        throw std::runtime_error("failed to allocate image memory!");
-    }
-
-    vkBindImageMemory(device->Handle(), image, imageMemory, 0);
+    subresourceStates.assign(mipLevels_ * arrayLayers, VulkanImageState{});
 }
@@ -1,6 +1,18 @@
 #pragma once
 
 #include "vk_common.h"
+#include "VulkanMemoryAllocator.h"
+
+// Layout and last access of an image subresource, as recorded so far
+struct VulkanImageState {
+    VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkPipelineStageFlags2 stages = VK_PIPELINE_STAGE_2_NONE;
+    VkAccessFlags2 accessMask = VK_ACCESS_2_NONE;
+
+    bool operator==(const VulkanImageState &other) const {
+        return layout == other.layout && stages == other.stages && accessMask == other.accessMask;
+    }
+};
 
 class VulkanImage : public std::enable_shared_from_this<VulkanImage> {
     VK_NON_COPIABLE(VulkanImage)
@@ -12,33 +24,69 @@ public:
                 uint32_t width, uint32_t height, VkSampleCountFlagBits numSamples, VkFormat format,
                 VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, bool useMipLevels);
 
+    // Creates the image without any memory, it has to be bound with BindMemory() before use.
+    // Used for transient attachments that share memory with other images.
+    VulkanImage(std::shared_ptr<VulkanInstance> instance_, std::shared_ptr<VulkanDevice> device_,
+                uint32_t width, uint32_t height, VkSampleCountFlagBits numSamples, VkFormat format, VkImageUsageFlags usage);
+
+    ~VulkanImage();
+
+    VkMemoryRequirements GetMemoryRequirements();
+
+    // Binds externally owned memory, the image won't free it on destruction
+    void BindMemory(VkDeviceMemory memory, VkDeviceSize offset);
+
     std::shared_ptr<VulkanImageView> GetView(VkFormat format, VkImageAspectFlags aspectFlags);
 
-    void ChangeLayout(std::shared_ptr<VulkanCommandBuffer> commandBuffer, VkImageLayout oldLayout, VkImageLayout newLayout);
+    // Transitions every subresource from its tracked state, for single transitions outside of a VulkanBarrierBatcher
+    void ChangeLayout(std::shared_ptr<VulkanCommandBuffer> commandBuffer, VkImageLayout newLayout, VkPipelineStageFlags2 stages, VkAccessFlags2 accessMask);
 
     void GetSize(uint32_t &width_, uint32_t &height_);
 
+    uint32_t GetMipLevels() const;
+
+    uint32_t GetArrayLayers() const;
+
+    VkImageAspectFlags GetAspectMask() const;
+
+    VulkanImageState GetSubresourceState(uint32_t mipLevel, uint32_t arrayLayer) const;
+
+    void SetSubresourceState(uint32_t mipLevel, uint32_t arrayLayer, const VulkanImageState &state);
+
+    VkFormat GetFormat() const;
+
     void GenerateMipMaps(std::shared_ptr<VulkanCommandPool> commandPool);
 
-public:
-    static uint32_t FindMemoryType(std::shared_ptr<VulkanInstance> instance, uint32_t typeFilter, VkMemoryPropertyFlags properties);
+    void GenerateMipMaps(std::shared_ptr<VulkanCommandBuffer> commandBuffer);
+
+    // Leaves the final transition of every mip level to shader reads in the batcher
+    void GenerateMipMaps(VulkanBarrierBatcher &barriers);
 
-    static std::shared_ptr<VulkanImage> LoadFrom(const char* path, std::shared_ptr<VulkanInstance> instance_, std::shared_ptr<VulkanDevice> device_, std::shared_ptr<VulkanCommandPool> commandPool);
+public:
+    static std::shared_ptr<VulkanImage> LoadFrom(const char* path, std::shared_ptr<VulkanInstance> instance_, std::shared_ptr<VulkanDevice> device_, std::shared_ptr<VulkanUploadContext> uploadContext);
 
 private:
     std::shared_ptr<VulkanDevice> device;
     std::shared_ptr<VulkanInstance> instance;
 
-    std::unordered_map<uint32_t, std::shared_ptr<VulkanImageView>> imageViewCache;
+    // Views keep their image alive, so the cache must not keep the views alive in return
+    std::unordered_map<uint32_t, std::weak_ptr<VulkanImageView>> imageViewCache;
 
     void CreateImageInternal(uint32_t width, uint32_t height, VkSampleCountFlagBits numSamples, VkFormat format,
                                                  VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, int mipLevels);
 
+    void CreateImageHandle(uint32_t width, uint32_t height, VkSampleCountFlagBits numSamples, VkFormat format,
+                           VkImageTiling tiling, VkImageUsageFlags usage, int mipLevels);
+
 private:
     VkFormat format;
-    VkDeviceMemory imageMemory;
+    VulkanMemoryAllocation allocation;
     uint32_t width, height;
     uint32_t mipLevels;
+    uint32_t arrayLayers = 1;
+    std::vector<VulkanImageState> subresourceStates; // Indexed by arrayLayer * mipLevels + mipLevel
+    bool ownsImage = true;  // Swap chain images belong to the swap chain
+    bool ownsMemory = true; // Aliased images live in memory owned by someone else
 
 VK_HANDLE(VkImage, image);
 };
@@ -1,10 +1,20 @@
 
 #include "VulkanImageView.h"
+#include "VulkanDevice.h"
+#include "VulkanDeletionQueue.h"
 
-VulkanImageView::VulkanImageView(VkImageView imageView_, std::shared_ptr<VulkanImage> image_) : imageView(imageView_), image(image_) {
+VulkanImageView::VulkanImageView(VkImageView imageView_, std::shared_ptr<VulkanImage> image_, std::shared_ptr<VulkanDevice> device_)
+    : imageView(imageView_), image(image_), device(device_) {
 
 }
 
+VulkanImageView::~VulkanImageView() {
+    VkDevice deviceHandle = device->Handle();
+    device->GetDeletionQueue()->Enqueue([deviceHandle, imageView = imageView]() mutable {
+        VkDestroy(vkDestroyImageView, deviceHandle, imageView);
+    });
+}
+
 std::shared_ptr<VulkanImage> VulkanImageView::GetImage() {
     return image;
 }
@@ -6,12 +6,15 @@ class VulkanImageView {
     VK_NON_COPIABLE(VulkanImageView)
 
 public:
-    VulkanImageView(VkImageView imageView_, std::shared_ptr<VulkanImage> image_);
+    VulkanImageView(VkImageView imageView_, std::shared_ptr<VulkanImage> image_, std::shared_ptr<VulkanDevice> device_);
+
+    ~VulkanImageView();
 
     std::shared_ptr<VulkanImage> GetImage();
 
 private:
     std::shared_ptr<VulkanImage> image;
+    std::shared_ptr<VulkanDevice> device;
 
 VK_HANDLE(VkImageView, imageView);
 };
@@ -21,7 +21,7 @@ VulkanInstance::VulkanInstance(std::shared_ptr<VulkanWindow> window_) : window(w
     appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
     appInfo.pEngineName = "No Engine";
     appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-    appInfo.apiVersion = VK_API_VERSION_1_2;
+    appInfo.apiVersion = VK_API_VERSION_1_3;
 
     VkInstanceCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -50,9 +50,20 @@ VulkanInstance::VulkanInstance(std::shared_ptr<VulkanWindow> window_) : window(w
 
     SetupDebugMessenger();
 
-    if (glfwCreateWindowSurface(instance, window->Handle(), nullptr, &surface) != VK_SUCCESS) {
+    if (window->IsHeadless()) {
+        VkHeadlessSurfaceCreateInfoEXT surfaceInfo{};
+        surfaceInfo.sType = VK_STRUCTURE_TYPE_HEADLESS_SURFACE_CREATE_INFO_EXT;
+
+        auto func = (PFN_vkCreateHeadlessSurfaceEXT) vkGetInstanceProcAddr(instance, "vkCreateHeadlessSurfaceEXT");
+        if (func == nullptr || func(instance, &surfaceInfo, nullptr, &surface) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create headless surface!");
+        }
+    }
+#ifndef VK_HEADLESS_ONLY
+    else if (glfwCreateWindowSurface(instance, window->Handle(), nullptr, &surface) != VK_SUCCESS) {
         throw std::runtime_error("failed to create window surface!");
     }
+#endif
 
     PickPhysicalDevice();
 }
@@ -83,11 +94,19 @@ bool VulkanInstance::CheckValidationLayerSupport() {
 }
 
 std::vector<const char *> VulkanInstance::GetRequiredExtensions() {
-    uint32_t glfwExtensionCount = 0;
-    const char **glfwExtensions;
-    glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+    std::vector<const char *> extensions;
+    if (window->IsHeadless()) {
+        extensions = {VK_KHR_SURFACE_EXTENSION_NAME, VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME};
+    }
+#ifndef VK_HEADLESS_ONLY
+    else {
+        uint32_t glfwExtensionCount = 0;
+        const char **glfwExtensions;
+        glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
 
-    std::vector<const char *> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+        extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+    }
+#endif
 
     if (EnableValidationLayers) {
         extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -202,10 +221,26 @@ bool VulkanInstance::IsDeviceSuitable(VkPhysicalDevice device) {
         swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
     }
 
-    VkPhysicalDeviceFeatures supportedFeatures;
-    vkGetPhysicalDeviceFeatures(device, &supportedFeatures);
+    // Vulkan 1.3 for synchronization2 as a core feature
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(device, &properties);
+    if (properties.apiVersion < VK_API_VERSION_1_3)
+        return false;
+
+    VkPhysicalDeviceVulkan13Features vulkan13Features{};
+    vulkan13Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
 
-    return indices.isComplete() && extensionsSupported && swapChainAdequate && supportedFeatures.samplerAnisotropy;
+    VkPhysicalDeviceVulkan12Features vulkan12Features{};
+    vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    vulkan12Features.pNext = &vulkan13Features;
+
+    VkPhysicalDeviceFeatures2 supportedFeatures{};
+    supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    supportedFeatures.pNext = &vulkan12Features;
+    vkGetPhysicalDeviceFeatures2(device, &supportedFeatures);
+
+    return indices.isComplete() && extensionsSupported && swapChainAdequate && supportedFeatures.features.samplerAnisotropy &&
+           vulkan12Features.timelineSemaphore && vulkan13Features.synchronization2;
 }
 
 QueueFamilyIndices VulkanInstance::FindQueueFamilies(VkPhysicalDevice device) {
@@ -219,19 +254,27 @@ QueueFamilyIndices VulkanInstance::FindQueueFamilies(VkPhysicalDevice device) {
 
     int i = 0;
     for (const auto &queueFamily: queueFamilies) {
-        if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
-            indices.graphicsFamily = i;
-        }
+        if (!indices.isComplete()) {
+            if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+                indices.graphicsFamily = i;
+            }
 
-        VkBool32 presentSupport = false;
-        vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
+            VkBool32 presentSupport = false;
+            vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
 
-        if (presentSupport) {
-            indices.presentFamily = i;
+            if (presentSupport) {
+                indices.presentFamily = i;
+            }
         }
 
-        if (indices.isComplete()) {
-            break;
+        // Prefer async compute families, and pure DMA families for transfers
+        bool isGraphics = queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT;
+        bool isCompute = queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT;
+        if (!isGraphics && isCompute && !indices.computeFamily.has_value()) {
+            indices.computeFamily = i;
+        }
+        if (!isGraphics && !isCompute && (queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT) && !indices.transferFamily.has_value()) {
+            indices.transferFamily = i;
         }
 
         i++;
@@ -244,6 +287,36 @@ QueueFamilyIndices VulkanInstance::FindQueueFamilies() {
     return FindQueueFamilies(physicalDevice);
 }
 
+bool VulkanInstance::IsDeviceExtensionSupported(const char *extensionName) {
+    auto availableExtensions = VkEnumerateVector(physicalDevice, nullptr, vkEnumerateDeviceExtensionProperties);
+    return std::any_of(availableExtensions.begin(), availableExtensions.end(), [&](const VkExtensionProperties &extension) {
+        return strcmp(extension.extensionName, extensionName) == 0;
+    });
+}
+
+VkFormat VulkanInstance::FindSupportedFormat(const std::vector<VkFormat> &candidates, VkImageTiling tiling, VkFormatFeatureFlags features) {
+    for (VkFormat format: candidates) {
+        VkFormatProperties props;
+        vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &props);
+
+        if (tiling == VK_IMAGE_TILING_LINEAR && (props.linearTilingFeatures & features) == features) {
+            return format;
+        } else if (tiling == VK_IMAGE_TILING_OPTIMAL && (props.optimalTilingFeatures & features) == features) {
+            return format;
+        }
+    }
+
+    throw std::runtime_error("failed to find supported format!");
+}
+
+VkFormat VulkanInstance::FindDepthFormat() {
+    return FindSupportedFormat(
+        {VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT},
+        VK_IMAGE_TILING_OPTIMAL,
+        VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT
+    );
+}
+
 bool VulkanInstance::CheckDeviceExtensionSupport(VkPhysicalDevice device) {
     uint32_t extensionCount;
     vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
@@ -309,5 +382,11 @@ uint32_t VulkanInstance::GetQueueFamilyIndex(QueueFamily queueFamily) {
     if (queueFamily == QueueFamily::Present)
         return queueFamilyIndices.presentFamily.value();
 
+    // Every graphics family supports compute and transfer as well, use it when there is no dedicated one
+    if (queueFamily == QueueFamily::Compute)
+        return queueFamilyIndices.computeFamily.value_or(queueFamilyIndices.graphicsFamily.value());
+    if (queueFamily == QueueFamily::Transfer)
+        return queueFamilyIndices.transferFamily.value_or(queueFamilyIndices.graphicsFamily.value());
+
     throw std::runtime_error("Queue type not supported");
 }
@@ -23,6 +23,12 @@ public:
 
     VkPhysicalDevice PhysicalDeviceHandle();
 
+    bool IsDeviceExtensionSupported(const char *extensionName);
+
+    VkFormat FindSupportedFormat(const std::vector<VkFormat> &candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
+
+    VkFormat FindDepthFormat();
+
     VkSurfaceKHR SurfaceHandle();
 
 private:
@@ -0,0 +1,579 @@
+#include "VulkanMemoryAllocator.h"
+
+#include <bit>
+#include <algorithm>
+#include <cstdio>
+
+#include "VulkanInstance.h"
+
+struct VulkanMemoryChunk {
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;
+    bool isFree = true;
+    bool isLinear = false;
+
+    VulkanMemoryChunk *prevPhysical = nullptr;
+    VulkanMemoryChunk *nextPhysical = nullptr;
+    VulkanMemoryChunk *prevFree = nullptr;
+    VulkanMemoryChunk *nextFree = nullptr;
+};
+
+// Two-Level Segregated Fit sub-allocator for a single VkDeviceMemory block.
+// Free chunks are bucketed by size class (power of two, then 16 linear subdivisions),
+// so looking up a large enough chunk is two bit scans instead of a walk over every free range.
+class VulkanMemoryBlock {
+    VK_NON_COPIABLE(VulkanMemoryBlock)
+
+public:
+    VulkanMemoryBlock(VkDeviceMemory memory_, VkDeviceSize size_, void *mappedData_);
+
+    ~VulkanMemoryBlock();
+
+    VulkanMemoryChunk *Allocate(VkDeviceSize allocationSize, VkDeviceSize alignment, VkDeviceSize granularity, bool isLinear);
+
+    void Free(VulkanMemoryChunk *chunk);
+
+    bool IsEmpty() const { return allocationCount == 0; }
+
+    VkDeviceMemory GetMemory() const { return memory; }
+
+    VkDeviceSize GetSize() const { return size; }
+
+    void *GetMappedData() const { return mappedData; }
+
+    uint32_t GetAllocationCount() const { return allocationCount; }
+
+    VkDeviceSize GetAllocatedBytes() const { return allocatedBytes; }
+
+private:
+    static void MapSize(VkDeviceSize chunkSize, uint32_t &firstLevel, uint32_t &secondLevel);
+
+    static VkDeviceSize RoundUpToSizeClass(VkDeviceSize chunkSize);
+
+    static bool IsOnSamePage(VkDeviceSize endOfA, VkDeviceSize startOfB, VkDeviceSize pageSize);
+
+    bool CheckFit(const VulkanMemoryChunk *chunk, VkDeviceSize allocationSize, VkDeviceSize alignment, VkDeviceSize granularity, bool isLinear,
+                  VkDeviceSize &alignedOffset) const;
+
+    void InsertFree(VulkanMemoryChunk *chunk);
+
+    void RemoveFree(VulkanMemoryChunk *chunk);
+
+private:
+    static constexpr uint32_t SecondLevelBits = 4;
+    static constexpr uint32_t SecondLevelCount = 1u << SecondLevelBits;
+    static constexpr uint32_t SmallSizeBits = 8; // Every chunk below 256 bytes lands in first level class 0
+    static constexpr uint32_t FirstLevelCount = 64 - SmallSizeBits + 1;
+
+    VkDeviceMemory memory;
+    VkDeviceSize size;
+    void *mappedData;
+
+    uint64_t firstLevelBitmap = 0;
+    uint32_t secondLevelBitmaps[FirstLevelCount]{};
+    VulkanMemoryChunk *freeLists[FirstLevelCount][SecondLevelCount]{};
+
+    VulkanMemoryChunk *firstChunk = nullptr;
+    uint32_t allocationCount = 0;
+    VkDeviceSize allocatedBytes = 0;
+};
+
+static VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+VulkanMemoryBlock::VulkanMemoryBlock(VkDeviceMemory memory_, VkDeviceSize size_, void *mappedData_)
+    : memory(memory_), size(size_), mappedData(mappedData_) {
+    firstChunk = new VulkanMemoryChunk{};
+    firstChunk->size = size;
+    InsertFree(firstChunk);
+}
+
+VulkanMemoryBlock::~VulkanMemoryBlock() {
+    VulkanMemoryChunk *chunk = firstChunk;
+    while (chunk != nullptr) {
+        VulkanMemoryChunk *next = chunk->nextPhysical;
+        delete chunk;
+        chunk = next;
+    }
+}
+
+void VulkanMemoryBlock::MapSize(VkDeviceSize chunkSize, uint32_t &firstLevel, uint32_t &secondLevel) {
+    if (chunkSize < (1ull << SmallSizeBits)) {
+        firstLevel = 0;
+        secondLevel = static_cast<uint32_t>(chunkSize / ((1ull << SmallSizeBits) / SecondLevelCount));
+        return;
+    }
+
+    uint32_t mostSignificantBit = 63 - std::countl_zero(chunkSize);
+    firstLevel = mostSignificantBit - SmallSizeBits + 1;
+    secondLevel = static_cast<uint32_t>(chunkSize >> (mostSignificantBit - SecondLevelBits)) ^ SecondLevelCount;
+}
+
+VkDeviceSize VulkanMemoryBlock::RoundUpToSizeClass(VkDeviceSize chunkSize) {
+    // Rounding up guarantees that every chunk in the resulting class is at least chunkSize bytes
+    if (chunkSize < (1ull << SmallSizeBits))
+        return AlignUp(chunkSize, (1ull << SmallSizeBits) / SecondLevelCount);
+
+    uint32_t mostSignificantBit = 63 - std::countl_zero(chunkSize);
+    return chunkSize + (1ull << (mostSignificantBit - SecondLevelBits)) - 1;
+}
+
+bool VulkanMemoryBlock::IsOnSamePage(VkDeviceSize endOfA, VkDeviceSize startOfB, VkDeviceSize pageSize) {
+    return (endOfA & ~(pageSize - 1)) == (startOfB & ~(pageSize - 1));
+}
+
+bool VulkanMemoryBlock::CheckFit(const VulkanMemoryChunk *chunk, VkDeviceSize allocationSize, VkDeviceSize alignment, VkDeviceSize granularity,
+                                 bool isLinear, VkDeviceSize &alignedOffset) const {
+    // Free chunks are always coalesced, so both physical neighbours of a free chunk are in use
+    alignedOffset = AlignUp(chunk->offset, alignment);
+
+    // Linear and optimal resources must not share a bufferImageGranularity page
+    const VulkanMemoryChunk *prev = chunk->prevPhysical;
+    if (granularity > 1 && prev != nullptr && prev->isLinear != isLinear && IsOnSamePage(prev->offset + prev->size - 1, alignedOffset, granularity))
+        alignedOffset = AlignUp(alignedOffset, granularity);
+
+    if (alignedOffset + allocationSize > chunk->offset + chunk->size)
+        return false;
+
+    const VulkanMemoryChunk *next = chunk->nextPhysical;
+    if (granularity > 1 && next != nullptr && next->isLinear != isLinear && IsOnSamePage(alignedOffset + allocationSize - 1, next->offset, granularity))
+        return false;
+
+    return true;
+}
+
+VulkanMemoryChunk *VulkanMemoryBlock::Allocate(VkDeviceSize allocationSize, VkDeviceSize alignment, VkDeviceSize granularity, bool isLinear) {
+    if (allocationSize > size)
+        return nullptr;
+
+    uint32_t firstLevel, secondLevel;
+    MapSize(RoundUpToSizeClass(allocationSize), firstLevel, secondLevel);
+
+    VulkanMemoryChunk *chunk = nullptr;
+    VkDeviceSize alignedOffset = 0;
+    while (chunk == nullptr && firstLevel < FirstLevelCount) {
+        uint32_t secondLevelMap = secondLevel < SecondLevelCount ? secondLevelBitmaps[firstLevel] & (~0u << secondLevel) : 0;
+        if (secondLevelMap == 0) {
+            uint64_t firstLevelMap = firstLevelBitmap & (~0ull << (firstLevel + 1));
+            if (firstLevelMap == 0)
+                return nullptr;
+
+            firstLevel = std::countr_zero(firstLevelMap);
+            secondLevel = 0;
+            continue;
+        }
+
+        // Every chunk in this class is large enough, but alignment and granularity may still rule some out
+        secondLevel = std::countr_zero(secondLevelMap);
+        for (VulkanMemoryChunk *candidate = freeLists[firstLevel][secondLevel]; candidate != nullptr; candidate = candidate->nextFree) {
+            if (CheckFit(candidate, allocationSize, alignment, granularity, isLinear, alignedOffset)) {
+                chunk = candidate;
+                break;
+            }
+        }
+        secondLevel++;
+    }
+
+    if (chunk == nullptr)
+        return nullptr;
+
+    RemoveFree(chunk);
+
+    VkDeviceSize padding = alignedOffset - chunk->offset;
+    if (padding > 0) {
+        auto paddingChunk = new VulkanMemoryChunk{};
+        paddingChunk->offset = chunk->offset;
+        paddingChunk->size = padding;
+        paddingChunk->prevPhysical = chunk->prevPhysical;
+        paddingChunk->nextPhysical = chunk;
+        if (chunk->prevPhysical != nullptr)
+            chunk->prevPhysical->nextPhysical = paddingChunk;
+        else
+            firstChunk = paddingChunk;
+        chunk->prevPhysical = paddingChunk;
+        chunk->offset = alignedOffset;
+        chunk->size -= padding;
+        InsertFree(paddingChunk);
+    }
+
+    if (chunk->size > allocationSize) {
+        auto remainderChunk = new VulkanMemoryChunk{};
+        remainderChunk->offset = chunk->offset + allocationSize;
+        remainderChunk->size = chunk->size - allocationSize;
+        remainderChunk->prevPhysical = chunk;
+        remainderChunk->nextPhysical = chunk->nextPhysical;
+        if (chunk->nextPhysical != nullptr)
+            chunk->nextPhysical->prevPhysical = remainderChunk;
+        chunk->nextPhysical = remainderChunk;
+        chunk->size = allocationSize;
+        InsertFree(remainderChunk);
+    }
+
+    chunk->isFree = false;
+    chunk->isLinear = isLinear;
+    allocationCount++;
+    allocatedBytes += chunk->size;
+
+    return chunk;
+}
+
+void VulkanMemoryBlock::Free(VulkanMemoryChunk *chunk) {
+    allocationCount--;
+    allocatedBytes -= chunk->size;
+    chunk->isFree = true;
+
+    VulkanMemoryChunk *prev = chunk->prevPhysical;
+    if (prev != nullptr && prev->isFree) {
+        RemoveFree(prev);
+        prev->size += chunk->size;
+        prev->nextPhysical = chunk->nextPhysical;
+        if (chunk->nextPhysical != nullptr)
+            chunk->nextPhysical->prevPhysical = prev;
+        delete chunk;
+        chunk = prev;
+    }
+
+    VulkanMemoryChunk *next = chunk->nextPhysical;
+    if (next != nullptr && next->isFree) {
+        RemoveFree(next);
+        chunk->size += next->size;
+        chunk->nextPhysical = next->nextPhysical;
+        if (next->nextPhysical != nullptr)
+            next->nextPhysical->prevPhysical = chunk;
+        delete next;
+    }
+
+    InsertFree(chunk);
+}
+
+void VulkanMemoryBlock::InsertFree(VulkanMemoryChunk *chunk) {
+    uint32_t firstLevel, secondLevel;
+    MapSize(chunk->size, firstLevel, secondLevel);
+
+    chunk->prevFree = nullptr;
+    chunk->nextFree = freeLists[firstLevel][secondLevel];
+    if (chunk->nextFree != nullptr)
+        chunk->nextFree->prevFree = chunk;
+    freeLists[firstLevel][secondLevel] = chunk;
+
+    firstLevelBitmap |= 1ull << firstLevel;
+    secondLevelBitmaps[firstLevel] |= 1u << secondLevel;
+}
+
+void VulkanMemoryBlock::RemoveFree(VulkanMemoryChunk *chunk) {
+    uint32_t firstLevel, secondLevel;
+    MapSize(chunk->size, firstLevel, secondLevel);
+
+    if (chunk->prevFree != nullptr)
+        chunk->prevFree->nextFree = chunk->nextFree;
+    else
+        freeLists[firstLevel][secondLevel] = chunk->nextFree;
+    if (chunk->nextFree != nullptr)
+        chunk->nextFree->prevFree = chunk->prevFree;
+    chunk->prevFree = nullptr;
+    chunk->nextFree = nullptr;
+
+    if (freeLists[firstLevel][secondLevel] == nullptr) {
+        secondLevelBitmaps[firstLevel] &= ~(1u << secondLevel);
+        if (secondLevelBitmaps[firstLevel] == 0)
+            firstLevelBitmap &= ~(1ull << firstLevel);
+    }
+}
+
+VulkanMemoryAllocator::VulkanMemoryAllocator(VkDevice device_, std::shared_ptr<VulkanInstance> instance_, bool useMemoryBudget_)
+    : instance(instance_), device(device_), useMemoryBudget(useMemoryBudget_) {
+    vkGetPhysicalDeviceMemoryProperties(instance->PhysicalDeviceHandle(), &memoryProperties);
+
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(instance->PhysicalDeviceHandle(), &properties);
+    bufferImageGranularity = properties.limits.bufferImageGranularity;
+    maxDeviceAllocationCount = properties.limits.maxMemoryAllocationCount;
+    nonCoherentAtomSize = properties.limits.nonCoherentAtomSize;
+
+    blocksPerType.resize(memoryProperties.memoryTypeCount);
+    dedicatedCountPerType.resize(memoryProperties.memoryTypeCount);
+    dedicatedBytesPerType.resize(memoryProperties.memoryTypeCount);
+}
+
+VulkanMemoryAllocator::~VulkanMemoryAllocator() {
+    for (auto &blocks: blocksPerType) {
+        for (auto &block: blocks)
+            FreeDeviceMemory(block->GetMemory());
+        blocks.clear();
+    }
+}
+
+uint32_t VulkanMemoryAllocator::FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags requiredProperties, VkMemoryPropertyFlags preferredProperties) const {
+    // First pass looks for a type that also has the preferred properties, the second one settles for the required ones
+    VkMemoryPropertyFlags candidates[] = {requiredProperties | preferredProperties, requiredProperties};
+    for (VkMemoryPropertyFlags properties: candidates) {
+        for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+            if ((typeFilter & (1 << i)) && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+                return i;
+            }
+        }
+    }
+
+    throw std::runtime_error("failed to find suitable memory type!");
+}
+
+VkDeviceSize VulkanMemoryAllocator::GetNonCoherentAtomSize() const {
+    return nonCoherentAtomSize;
+}
+
+VkDeviceSize VulkanMemoryAllocator::GetPreferredBlockSize(uint32_t memoryTypeIndex) const {
+    VkDeviceSize heapSize = memoryProperties.memoryHeaps[memoryProperties.memoryTypes[memoryTypeIndex].heapIndex].size;
+    return heapSize <= SmallHeapThreshold ? AlignUp(heapSize / 8, 32) : LargeHeapBlockSize;
+}
+
+VkResult VulkanMemoryAllocator::AllocateDeviceMemory(VkDeviceSize size, uint32_t memoryTypeIndex, VkDeviceMemory &memory, void *&mappedData) {
+    if (deviceAllocationCount >= maxDeviceAllocationCount)
+        return VK_ERROR_TOO_MANY_OBJECTS;
+
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = size;
+    allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+    VkResult result = vkAllocateMemory(device, &allocInfo, nullptr, &memory);
+    if (result != VK_SUCCESS)
+        return result;
+
+    // Host visible blocks stay mapped for their whole lifetime, sub-allocations just offset into the mapping
+    mappedData = nullptr;
+    if (memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+        result = vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, &mappedData);
+        if (result != VK_SUCCESS) {
+            vkFreeMemory(device, memory, nullptr);
+            return result;
+        }
+    }
+
+    deviceAllocationCount++;
+    return VK_SUCCESS;
+}
+
+void VulkanMemoryAllocator::FreeDeviceMemory(VkDeviceMemory memory) {
+    vkFreeMemory(device, memory, nullptr);
+    deviceAllocationCount--;
+}
+
+VulkanMemoryAllocation VulkanMemoryAllocator::AllocateDedicated(VkDeviceSize size, uint32_t memoryTypeIndex) {
+    VulkanMemoryAllocation allocation{};
+    if (AllocateDeviceMemory(size, memoryTypeIndex, allocation.memory, allocation.mappedData) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate device memory!");
+    }
+
+    allocation.size = size;
+    allocation.memoryTypeIndex = memoryTypeIndex;
+    allocation.propertyFlags = memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags;
+    allocation.memorySize = size;
+
+    dedicatedCountPerType[memoryTypeIndex]++;
+    dedicatedBytesPerType[memoryTypeIndex] += size;
+
+    return allocation;
+}
+
+VulkanMemoryAllocation VulkanMemoryAllocator::Allocate(const VkMemoryRequirements &memoryRequirements, VkMemoryPropertyFlags requiredProperties,
+                                                       VkMemoryPropertyFlags preferredProperties, bool isLinear, VulkanMemoryCategory category) {
+    uint32_t memoryTypeIndex = FindMemoryType(memoryRequirements.memoryTypeBits, requiredProperties, preferredProperties);
+    VkMemoryPropertyFlags propertyFlags = memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags;
+    VkDeviceSize blockSize = GetPreferredBlockSize(memoryTypeIndex);
+
+    // Non-coherent allocations are padded to whole atoms so that flushing one never touches a neighbour's memory
+    VkMemoryRequirements requirements = memoryRequirements;
+    if ((propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) && !(propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
+        requirements.alignment = std::max(requirements.alignment, nonCoherentAtomSize);
+        requirements.size = AlignUp(requirements.size, nonCoherentAtomSize);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (requirements.size > blockSize / 2) {
+        VulkanMemoryAllocation allocation = AllocateDedicated(requirements.size, memoryTypeIndex);
+        allocation.category = category;
+        categoryStatistics[static_cast<size_t>(category)].allocationCount++;
+        categoryStatistics[static_cast<size_t>(category)].allocationBytes += allocation.size;
+        return allocation;
+    }
+
+    auto &blocks = blocksPerType[memoryTypeIndex];
+    VulkanMemoryBlock *block = nullptr;
+    VulkanMemoryChunk *chunk = nullptr;
+    for (auto &candidate: blocks) {
+        chunk = candidate->Allocate(requirements.size, requirements.alignment, bufferImageGranularity, isLinear);
+        if (chunk != nullptr) {
+            block = candidate.get();
+            break;
+        }
+    }
+
+    if (chunk == nullptr) {
+        // Every block is full, reserve a new one. Under memory pressure retry with smaller blocks before giving up.
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        void *mappedData = nullptr;
+        VkResult result = AllocateDeviceMemory(blockSize, memoryTypeIndex, memory, mappedData);
+        while (result != VK_SUCCESS && result != VK_ERROR_TOO_MANY_OBJECTS && blockSize / 2 >= requirements.size * 2) {
+            blockSize /= 2;
+            result = AllocateDeviceMemory(blockSize, memoryTypeIndex, memory, mappedData);
+        }
+
+        if (result != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate device memory!");
+        }
+
+        blocks.push_back(std::make_unique<VulkanMemoryBlock>(memory, blockSize, mappedData));
+        block = blocks.back().get();
+        chunk = block->Allocate(requirements.size, requirements.alignment, bufferImageGranularity, isLinear);
+    }
+
+    VulkanMemoryAllocation allocation{};
+    allocation.memory = block->GetMemory();
+    allocation.offset = chunk->offset;
+    allocation.size = chunk->size;
+    allocation.memoryTypeIndex = memoryTypeIndex;
+    allocation.propertyFlags = propertyFlags;
+    allocation.memorySize = block->GetSize();
+    allocation.mappedData = block->GetMappedData() != nullptr ? static_cast<char *>(block->GetMappedData()) + chunk->offset : nullptr;
+    allocation.block = block;
+    allocation.chunk = chunk;
+    allocation.category = category;
+
+    categoryStatistics[static_cast<size_t>(category)].allocationCount++;
+    categoryStatistics[static_cast<size_t>(category)].allocationBytes += allocation.size;
+
+    return allocation;
+}
+
+void VulkanMemoryAllocator::Free(VulkanMemoryAllocation &allocation) {
+    if (allocation.memory == VK_NULL_HANDLE)
+        return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    categoryStatistics[static_cast<size_t>(allocation.category)].allocationCount--;
+    categoryStatistics[static_cast<size_t>(allocation.category)].allocationBytes -= allocation.size;
+
+    if (allocation.block == nullptr) {
+        FreeDeviceMemory(allocation.memory);
+        dedicatedCountPerType[allocation.memoryTypeIndex]--;
+        dedicatedBytesPerType[allocation.memoryTypeIndex] -= allocation.size;
+    } else {
+        allocation.block->Free(allocation.chunk);
+
+        // Keep a single empty block around per memory type so that alloc/free patterns don't thrash vkAllocateMemory
+        if (allocation.block->IsEmpty()) {
+            auto &blocks = blocksPerType[allocation.memoryTypeIndex];
+            auto emptyCount = std::count_if(blocks.begin(), blocks.end(), [](const auto &block) { return block->IsEmpty(); });
+            if (emptyCount > 1) {
+                auto match = std::find_if(blocks.begin(), blocks.end(), [&](const auto &block) { return block.get() == allocation.block; });
+                FreeDeviceMemory((*match)->GetMemory());
+                blocks.erase(match);
+            }
+        }
+    }
+
+    allocation = {};
+}
+
+VulkanMemoryStatistics VulkanMemoryAllocator::GetStatistics() {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    VulkanMemoryStatistics statistics{};
+    statistics.categories = categoryStatistics;
+
+    statistics.heaps.resize(memoryProperties.memoryHeapCount);
+    for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++) {
+        statistics.heaps[i].heapIndex = i;
+        statistics.heaps[i].heapSize = memoryProperties.memoryHeaps[i].size;
+        statistics.heaps[i].heapFlags = memoryProperties.memoryHeaps[i].flags;
+    }
+
+    statistics.memoryTypes.resize(memoryProperties.memoryTypeCount);
+    for (uint32_t type = 0; type < memoryProperties.memoryTypeCount; type++) {
+        auto &typeStatistics = statistics.memoryTypes[type];
+        typeStatistics.memoryTypeIndex = type;
+        typeStatistics.heapIndex = memoryProperties.memoryTypes[type].heapIndex;
+        typeStatistics.propertyFlags = memoryProperties.memoryTypes[type].propertyFlags;
+
+        auto &usage = typeStatistics.usage;
+        for (const auto &block: blocksPerType[type]) {
+            usage.blockCount++;
+            usage.blockBytes += block->GetSize();
+            usage.allocationCount += block->GetAllocationCount();
+            usage.allocationBytes += block->GetAllocatedBytes();
+        }
+
+        usage.dedicatedAllocationCount += dedicatedCountPerType[type];
+        usage.allocationCount += dedicatedCountPerType[type];
+        usage.blockBytes += dedicatedBytesPerType[type];
+        usage.allocationBytes += dedicatedBytesPerType[type];
+
+        for (VulkanMemoryUsage *total: {&statistics.heaps[typeStatistics.heapIndex].usage, &statistics.total}) {
+            total->blockCount += usage.blockCount;
+            total->dedicatedAllocationCount += usage.dedicatedAllocationCount;
+            total->allocationCount += usage.allocationCount;
+            total->blockBytes += usage.blockBytes;
+            total->allocationBytes += usage.allocationBytes;
+        }
+    }
+
+    if (useMemoryBudget) {
+        VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties{};
+        budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+        VkPhysicalDeviceMemoryProperties2 memoryProperties2{};
+        memoryProperties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+        memoryProperties2.pNext = &budgetProperties;
+        vkGetPhysicalDeviceMemoryProperties2(instance->PhysicalDeviceHandle(), &memoryProperties2);
+
+        statistics.hasMemoryBudget = true;
+        for (auto &heap: statistics.heaps) {
+            heap.budgetBytes = budgetProperties.heapBudget[heap.heapIndex];
+            heap.usageBytes = budgetProperties.heapUsage[heap.heapIndex];
+        }
+    } else {
+        for (auto &heap: statistics.heaps) {
+            heap.budgetBytes = heap.heapSize;
+            heap.usageBytes = heap.usage.blockBytes;
+        }
+    }
+
+    return statistics;
+}
+
+void VulkanMemoryAllocator::PrintStatistics() {
+    const double MiB = 1024.0 * 1024.0;
+
+    VulkanMemoryStatistics statistics = GetStatistics();
+    for (const auto &heap: statistics.heaps) {
+        printf("Heap %u (%s, %.0f MiB): %u blocks, %u dedicated, %u allocations, %.2f / %.2f MiB used, %.2f / %.2f MiB budget%s\n",
+               heap.heapIndex, (heap.heapFlags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) ? "device" : "host", heap.heapSize / MiB,
+               heap.usage.blockCount, heap.usage.dedicatedAllocationCount, heap.usage.allocationCount, heap.usage.allocationBytes / MiB, heap.usage.blockBytes / MiB,
+               heap.usageBytes / MiB, heap.budgetBytes / MiB, statistics.hasMemoryBudget ? "" : " (estimated)");
+    }
+
+    printf("Memory by category:");
+    for (size_t i = 0; i < statistics.categories.size(); i++) {
+        printf(" %s %u (%.2f MiB)", GetCategoryName(static_cast<VulkanMemoryCategory>(i)),
+               statistics.categories[i].allocationCount, statistics.categories[i].allocationBytes / MiB);
+    }
+    printf("\n");
+}
+
+const char *VulkanMemoryAllocator::GetCategoryName(VulkanMemoryCategory category) {
+    switch (category) {
+        case VulkanMemoryCategory::Buffer:
+            return "buffer";
+        case VulkanMemoryCategory::Image:
+            return "image";
+        case VulkanMemoryCategory::Staging:
+            return "staging";
+        case VulkanMemoryCategory::Attachment:
+            return "attachment";
+        default:
+            return "unknown";
+    }
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <mutex>
+#include <array>
+
+#include "vk_common.h"
+
+class VulkanMemoryBlock;
+struct VulkanMemoryChunk;
+
+enum class VulkanMemoryCategory {
+    Buffer,
+    Image,
+    Staging,
+    Attachment,
+    Count
+};
+
+struct VulkanMemoryAllocation {
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;
+    uint32_t memoryTypeIndex = 0;
+    VkMemoryPropertyFlags propertyFlags = 0;
+    VkDeviceSize memorySize = 0; // Size of the whole VkDeviceMemory object, needed to clamp flush ranges
+    void *mappedData = nullptr;
+    VulkanMemoryCategory category = VulkanMemoryCategory::Buffer;
+
+    // Owning block and chunk, both null for dedicated allocations
+    VulkanMemoryBlock *block = nullptr;
+    VulkanMemoryChunk *chunk = nullptr;
+};
+
+struct VulkanMemoryUsage {
+    uint32_t blockCount = 0;
+    uint32_t dedicatedAllocationCount = 0;
+    uint32_t allocationCount = 0;
+
+    VkDeviceSize blockBytes = 0;     // Memory reserved with vkAllocateMemory (blocks + dedicated allocations)
+    VkDeviceSize allocationBytes = 0; // Memory handed out to resources
+};
+
+struct VulkanMemoryTypeStatistics {
+    uint32_t memoryTypeIndex = 0;
+    uint32_t heapIndex = 0;
+    VkMemoryPropertyFlags propertyFlags = 0;
+    VulkanMemoryUsage usage;
+};
+
+struct VulkanMemoryHeapStatistics {
+    uint32_t heapIndex = 0;
+    VkDeviceSize heapSize = 0;
+    VkMemoryHeapFlags heapFlags = 0;
+    VulkanMemoryUsage usage;
+
+    // Live values reported by VK_EXT_memory_budget, covering other processes and driver internal allocations too.
+    // Without the extension the budget falls back to the heap size and the usage to our own block bytes.
+    VkDeviceSize budgetBytes = 0;
+    VkDeviceSize usageBytes = 0;
+};
+
+struct VulkanMemoryCategoryStatistics {
+    uint32_t allocationCount = 0;
+    VkDeviceSize allocationBytes = 0;
+};
+
+struct VulkanMemoryStatistics {
+    bool hasMemoryBudget = false;
+    std::vector<VulkanMemoryTypeStatistics> memoryTypes;
+    std::vector<VulkanMemoryHeapStatistics> heaps;
+    std::array<VulkanMemoryCategoryStatistics, static_cast<size_t>(VulkanMemoryCategory::Count)> categories{};
+    VulkanMemoryUsage total;
+};
+
+class VulkanMemoryAllocator {
+    VK_NON_COPIABLE(VulkanMemoryAllocator)
+
+public:
+    VulkanMemoryAllocator(VkDevice device_, std::shared_ptr<VulkanInstance> instance_, bool useMemoryBudget_);
+
+    ~VulkanMemoryAllocator();
+
+    VulkanMemoryAllocation Allocate(const VkMemoryRequirements &requirements, VkMemoryPropertyFlags requiredProperties,
+                                    VkMemoryPropertyFlags preferredProperties, bool isLinear, VulkanMemoryCategory category);
+
+    void Free(VulkanMemoryAllocation &allocation);
+
+    uint32_t FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags requiredProperties, VkMemoryPropertyFlags preferredProperties = 0) const;
+
+    VkDeviceSize GetNonCoherentAtomSize() const;
+
+    VulkanMemoryStatistics GetStatistics();
+
+    void PrintStatistics();
+
+    static const char *GetCategoryName(VulkanMemoryCategory category);
+
+private:
+    VkDeviceSize GetPreferredBlockSize(uint32_t memoryTypeIndex) const;
+
+    VkResult AllocateDeviceMemory(VkDeviceSize size, uint32_t memoryTypeIndex, VkDeviceMemory &memory, void *&mappedData);
+
+    void FreeDeviceMemory(VkDeviceMemory memory);
+
+    VulkanMemoryAllocation AllocateDedicated(VkDeviceSize size, uint32_t memoryTypeIndex);
+
+private:
+    static constexpr VkDeviceSize LargeHeapBlockSize = 64ull * 1024 * 1024;
+    static constexpr VkDeviceSize SmallHeapThreshold = 1024ull * 1024 * 1024;
+
+    std::shared_ptr<VulkanInstance> instance;
+    VkDevice device;
+
+    VkPhysicalDeviceMemoryProperties memoryProperties{};
+    VkDeviceSize bufferImageGranularity = 1;
+    VkDeviceSize nonCoherentAtomSize = 1;
+
+    std::mutex mutex;
+    std::vector<std::vector<std::unique_ptr<VulkanMemoryBlock>>> blocksPerType;
+    std::vector<uint32_t> dedicatedCountPerType;
+    std::vector<VkDeviceSize> dedicatedBytesPerType;
+    uint32_t deviceAllocationCount = 0;
+    uint32_t maxDeviceAllocationCount = 0;
+
+    bool useMemoryBudget;
+    std::array<VulkanMemoryCategoryStatistics, static_cast<size_t>(VulkanMemoryCategory::Count)> categoryStatistics{};
+};
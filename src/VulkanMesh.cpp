@@ -4,6 +4,7 @@
 
 #include "VulkanBuffer.h"
 #include "VulkanCommandBuffer.h"
+#include "VulkanUploadContext.h"
 
 VulkanMesh::VulkanMesh(const char *path) {
     tinyobj::attrib_t attrib;
@@ -44,33 +45,27 @@ VulkanMesh::VulkanMesh(const char *path) {
     }
 }
 
-void VulkanMesh::CreateBuffers(std::shared_ptr<VulkanCommandPool> commandPool, std::shared_ptr<VulkanInstance> instance, std::shared_ptr<VulkanDevice> device) {
-    CreateIndexBuffer(commandPool, instance, device);
-    CreateVertexBuffer(commandPool, instance, device);
+void VulkanMesh::CreateBuffers(std::shared_ptr<VulkanUploadContext> uploadContext, std::shared_ptr<VulkanInstance> instance, std::shared_ptr<VulkanDevice> device) {
+    CreateIndexBuffer(uploadContext, instance, device);
+    CreateVertexBuffer(uploadContext, instance, device);
 }
 
-void VulkanMesh::CreateIndexBuffer(std::shared_ptr<VulkanCommandPool> commandPool, std::shared_ptr<VulkanInstance> instance, std::shared_ptr<VulkanDevice> device) {
+void VulkanMesh::CreateIndexBuffer(std::shared_ptr<VulkanUploadContext> uploadContext, std::shared_ptr<VulkanInstance> instance, std::shared_ptr<VulkanDevice> device) {
     VkDeviceSize bufferSize = sizeof(indices[0]) * indices.size();
 
-    auto stagingBuffer = std::make_shared<VulkanBuffer>(device, instance, bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                                                        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
     indexBuffer = std::make_shared<VulkanBuffer>(device, instance, bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
                                                  VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
-    stagingBuffer->CopyFrom(indices.data(), bufferSize);
-    stagingBuffer->CopyTo(commandPool, indexBuffer, bufferSize);
+    uploadContext->UploadBuffer(indexBuffer, indices.data(), bufferSize);
 }
 
-void VulkanMesh::CreateVertexBuffer(std::shared_ptr<VulkanCommandPool> commandPool, std::shared_ptr<VulkanInstance> instance, std::shared_ptr<VulkanDevice> device) {
+void VulkanMesh::CreateVertexBuffer(std::shared_ptr<VulkanUploadContext> uploadContext, std::shared_ptr<VulkanInstance> instance, std::shared_ptr<VulkanDevice> device) {
     VkDeviceSize bufferSize = sizeof(vertices[0]) * vertices.size();
 
-    auto stagingBuffer = std::make_shared<VulkanBuffer>(device, instance, bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                                                        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
     vertexBuffer = std::make_shared<VulkanBuffer>(device, instance, bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
                                                   VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
-    stagingBuffer->CopyFrom(vertices.data(), bufferSize);
-    stagingBuffer->CopyTo(commandPool, vertexBuffer, bufferSize);
+    uploadContext->UploadBuffer(vertexBuffer, vertices.data(), bufferSize);
 }
 
 void VulkanMesh::Bind(std::shared_ptr<VulkanCommandBuffer> commandBuffer) {
@@ -8,16 +8,16 @@ class VulkanMesh {
 public:
     VulkanMesh(const char *path);
 
-    void CreateBuffers(std::shared_ptr<VulkanCommandPool> commandPool, std::shared_ptr<VulkanInstance> instance, std::shared_ptr<VulkanDevice> device);
+    void CreateBuffers(std::shared_ptr<VulkanUploadContext> uploadContext, std::shared_ptr<VulkanInstance> instance, std::shared_ptr<VulkanDevice> device);
 
     void Bind(std::shared_ptr<VulkanCommandBuffer> commandBuffer);
 
     void Draw(std::shared_ptr<VulkanCommandBuffer> commandBuffer);
 
 private:
-    void CreateIndexBuffer(std::shared_ptr<VulkanCommandPool> commandPool, std::shared_ptr<VulkanInstance> instance, std::shared_ptr<VulkanDevice> device);
+    void CreateIndexBuffer(std::shared_ptr<VulkanUploadContext> uploadContext, std::shared_ptr<VulkanInstance> instance, std::shared_ptr<VulkanDevice> device);
 
-    void CreateVertexBuffer(std::shared_ptr<VulkanCommandPool> commandPool, std::shared_ptr<VulkanInstance> instance, std::shared_ptr<VulkanDevice> device);
+    void CreateVertexBuffer(std::shared_ptr<VulkanUploadContext> uploadContext, std::shared_ptr<VulkanInstance> instance, std::shared_ptr<VulkanDevice> device);
 
 private:
     std::vector<Vertex> vertices;
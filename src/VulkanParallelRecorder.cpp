@@ -0,0 +1,115 @@
+#include "VulkanParallelRecorder.h"
+#include "VulkanFrameContext.h"
+#include "VulkanCommandBuffer.h"
+#include "VulkanRenderPass.h"
+
+VulkanParallelRecorder::VulkanParallelRecorder(uint32_t threadCount_) {
+    tasks.resize(threadCount_);
+    for (uint32_t i = 0; i < threadCount_; i++)
+        workers.emplace_back(&VulkanParallelRecorder::WorkerLoop, this, i);
+}
+
+VulkanParallelRecorder::~VulkanParallelRecorder() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        isStopping = true;
+    }
+    workAvailable.notify_all();
+
+    for (auto &worker: workers)
+        worker.join();
+}
+
+uint32_t VulkanParallelRecorder::GetThreadCount() const {
+    return static_cast<uint32_t>(workers.size());
+}
+
+void VulkanParallelRecorder::Record(std::shared_ptr<VulkanFrameContext> frameContext, std::shared_ptr<VulkanCommandBuffer> primaryCommandBuffer,
+                                    std::shared_ptr<VulkanRenderPass> renderPass, std::shared_ptr<VulkanFramebuffer> framebuffer,
+                                    size_t itemCount, const RecordCallback &recordCallback) {
+    auto secondaryCommandBuffers = RecordSecondary(frameContext, renderPass, framebuffer, itemCount, recordCallback);
+
+    renderPass->Begin(primaryCommandBuffer, framebuffer, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+    primaryCommandBuffer->ExecuteCommands(secondaryCommandBuffers);
+    renderPass->End(primaryCommandBuffer);
+}
+
+std::vector<std::shared_ptr<VulkanCommandBuffer>> VulkanParallelRecorder::RecordSecondary(std::shared_ptr<VulkanFrameContext> frameContext,
+                                                                                          std::shared_ptr<VulkanRenderPass> renderPass,
+                                                                                          std::shared_ptr<VulkanFramebuffer> framebuffer,
+                                                                                          size_t itemCount, const RecordCallback &recordCallback) {
+    if (frameContext->GetThreadCount() < GetThreadCount()) {
+        throw std::runtime_error("frame context has fewer thread pools than the recorder has workers!");
+    }
+
+    size_t chunkCount = std::min<size_t>(GetThreadCount(), itemCount);
+    std::vector<std::shared_ptr<VulkanCommandBuffer>> secondaryCommandBuffers(chunkCount);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t chunk = 0; chunk < chunkCount; chunk++) {
+            size_t begin = itemCount * chunk / chunkCount;
+            size_t end = itemCount * (chunk + 1) / chunkCount;
+            uint32_t threadIndex = static_cast<uint32_t>(chunk);
+
+            tasks[threadIndex] = [=, &secondaryCommandBuffers, &recordCallback]() {
+                auto commandBuffer = frameContext->AllocateSecondaryCommandBuffer(threadIndex);
+                commandBuffer->BeginSecondary(renderPass, framebuffer);
+                recordCallback(commandBuffer, begin, end);
+                commandBuffer->End();
+                secondaryCommandBuffers[chunk] = commandBuffer;
+            };
+        }
+
+        pendingCount = GetThreadCount();
+        firstError = nullptr;
+        generation++;
+    }
+    workAvailable.notify_all();
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        workDone.wait(lock, [this]() { return pendingCount == 0; });
+
+        if (firstError) {
+            std::rethrow_exception(firstError);
+        }
+    }
+
+    return secondaryCommandBuffers;
+}
+
+void VulkanParallelRecorder::WorkerLoop(uint32_t threadIndex) {
+    uint64_t seenGeneration = 0;
+
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            workAvailable.wait(lock, [&]() { return isStopping || generation != seenGeneration; });
+            if (isStopping)
+                return;
+
+            seenGeneration = generation;
+            task = std::move(tasks[threadIndex]);
+            tasks[threadIndex] = nullptr;
+        }
+
+        std::exception_ptr error;
+        if (task) {
+            try {
+                task();
+            } catch (...) {
+                error = std::current_exception();
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (error && !firstError)
+                firstError = error;
+            pendingCount--;
+        }
+        workDone.notify_one();
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <thread>
+#include <algorithm>
+#include <mutex>
+#include <functional>
+#include <condition_variable>
+
+#include "vk_common.h"
+
+// Splits a draw list across a fixed set of worker threads. Every worker records its share into a
+// secondary command buffer allocated from its own pool of the frame context, and the results are
+// executed in order inside a render pass instance of the primary command buffer.
+class VulkanParallelRecorder {
+    VK_NON_COPIABLE(VulkanParallelRecorder)
+
+public:
+    // Records draw list items [begin, end) into an already begun secondary command buffer.
+    // Secondary command buffers inherit no state, so pipelines and descriptor sets have to be bound here.
+    using RecordCallback = std::function<void(std::shared_ptr<VulkanCommandBuffer> commandBuffer, size_t begin, size_t end)>;
+
+    explicit VulkanParallelRecorder(uint32_t threadCount_ = std::max(1u, std::thread::hardware_concurrency()));
+
+    ~VulkanParallelRecorder();
+
+    uint32_t GetThreadCount() const;
+
+    void Record(std::shared_ptr<VulkanFrameContext> frameContext, std::shared_ptr<VulkanCommandBuffer> primaryCommandBuffer,
+                std::shared_ptr<VulkanRenderPass> renderPass, std::shared_ptr<VulkanFramebuffer> framebuffer,
+                size_t itemCount, const RecordCallback &recordCallback);
+
+    // Only records the secondary command buffers, for callers that begin the render pass instance themselves
+    std::vector<std::shared_ptr<VulkanCommandBuffer>> RecordSecondary(std::shared_ptr<VulkanFrameContext> frameContext,
+                                                                      std::shared_ptr<VulkanRenderPass> renderPass, std::shared_ptr<VulkanFramebuffer> framebuffer,
+                                                                      size_t itemCount, const RecordCallback &recordCallback);
+
+private:
+    void WorkerLoop(uint32_t threadIndex);
+
+private:
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::condition_variable workDone;
+
+    std::vector<std::function<void()>> tasks; // One slot per worker, empty when the worker has nothing to do
+    uint64_t generation = 0;
+    uint32_t pendingCount = 0;
+    bool isStopping = false;
+    std::exception_ptr firstError;
+};
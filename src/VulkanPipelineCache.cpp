@@ -0,0 +1,101 @@
+#include "VulkanPipelineCache.h"
+
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+
+#include "VulkanInstance.h"
+
+VulkanPipelineCache::VulkanPipelineCache(VkDevice device_, std::shared_ptr<VulkanInstance> instance_, std::string path_)
+    : device(device_), instance(instance_), path(std::move(path_)) {
+    std::vector<char> initialData = LoadValidatedData();
+    isWarm = !initialData.empty();
+
+    VkPipelineCacheCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    createInfo.initialDataSize = initialData.size();
+    createInfo.pInitialData = initialData.empty() ? nullptr : initialData.data();
+
+    if (vkCreatePipelineCache(device, &createInfo, nullptr, &pipelineCache) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create pipeline cache!");
+    }
+}
+
+VulkanPipelineCache::~VulkanPipelineCache() {
+    // Losing the cache only costs compilation time on the next start, it must not take the shutdown down with it
+    try {
+        Save();
+    } catch (const std::exception &e) {
+        fprintf(stderr, "failed to save pipeline cache: %s\n", e.what());
+    }
+
+    // Pipelines don't reference the cache after creation, so it can go right away
+    VkDestroy(vkDestroyPipelineCache, device, pipelineCache);
+}
+
+void VulkanPipelineCache::Save() {
+    size_t dataSize = 0;
+    if (vkGetPipelineCacheData(device, pipelineCache, &dataSize, nullptr) != VK_SUCCESS) {
+        throw std::runtime_error("failed to get pipeline cache size!");
+    }
+
+    std::vector<char> data(dataSize);
+    if (vkGetPipelineCacheData(device, pipelineCache, &dataSize, data.data()) != VK_SUCCESS) {
+        throw std::runtime_error("failed to get pipeline cache data!");
+    }
+
+    std::string temporaryPath = path + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            throw std::runtime_error("failed to open pipeline cache file for writing!");
+        }
+
+        file.write(data.data(), static_cast<std::streamsize>(dataSize));
+        if (!file.good()) {
+            throw std::runtime_error("failed to write pipeline cache file!");
+        }
+    }
+
+    // rename() doesn't replace an existing file everywhere
+    std::remove(path.c_str());
+    if (std::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error("failed to replace pipeline cache file!");
+    }
+}
+
+bool VulkanPipelineCache::IsWarm() const {
+    return isWarm;
+}
+
+std::vector<char> VulkanPipelineCache::LoadValidatedData() {
+    std::ifstream file(path, std::ios::ate | std::ios::binary);
+    if (!file.is_open())
+        return {};
+
+    size_t fileSize = (size_t) file.tellg();
+    std::vector<char> data(fileSize);
+
+    file.seekg(0);
+    file.read(data.data(), fileSize);
+    if (!file.good() || !IsHeaderValid(data))
+        return {};
+
+    return data;
+}
+
+bool VulkanPipelineCache::IsHeaderValid(const std::vector<char> &data) {
+    VkPipelineCacheHeaderVersionOne header{};
+    if (data.size() < sizeof(header))
+        return false;
+    memcpy(&header, data.data(), sizeof(header));
+
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(instance->PhysicalDeviceHandle(), &properties);
+
+    return header.headerSize >= sizeof(header) && header.headerSize <= data.size() &&
+           header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+           header.vendorID == properties.vendorID &&
+           header.deviceID == properties.deviceID &&
+           memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+
+#include "vk_common.h"
+
+// Device-wide VkPipelineCache backed by a file. The file is only used when the header written by the
+// driver matches the current physical device, so a driver update or a different GPU starts with an empty
+// cache instead of handing incompatible data to the driver. The data is written back on destruction.
+class VulkanPipelineCache {
+    VK_NON_COPIABLE(VulkanPipelineCache)
+
+public:
+    VulkanPipelineCache(VkDevice device_, std::shared_ptr<VulkanInstance> instance_, std::string path_);
+
+    ~VulkanPipelineCache();
+
+    // Writes the current cache contents to disk, through a temporary file so a crash can't leave a truncated cache behind
+    void Save();
+
+    // Whether usable data was found on disk when the cache was created
+    bool IsWarm() const;
+
+private:
+    std::vector<char> LoadValidatedData();
+
+    bool IsHeaderValid(const std::vector<char> &data);
+
+private:
+    VkDevice device;
+    std::shared_ptr<VulkanInstance> instance;
+    std::string path;
+    bool isWarm = false;
+
+VK_HANDLE(VkPipelineCache, pipelineCache);
+};
@@ -0,0 +1,105 @@
+#include "VulkanPipelineManager.h"
+
+VulkanPipelineManager::VulkanPipelineManager(std::shared_ptr<VulkanDevice> device_, uint32_t threadCount_)
+    : device(device_) {
+    for (uint32_t i = 0; i < threadCount_; i++)
+        workers.emplace_back(&VulkanPipelineManager::WorkerLoop, this);
+}
+
+VulkanPipelineManager::~VulkanPipelineManager() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        isStopping = true;
+    }
+    workAvailable.notify_all();
+
+    for (auto &worker: workers)
+        worker.join();
+}
+
+uint32_t VulkanPipelineManager::GetThreadCount() const {
+    return static_cast<uint32_t>(workers.size());
+}
+
+VulkanPipelineManager::PipelineFuture VulkanPipelineManager::Request(const VulkanGraphicsPipelineState &state) {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    auto existing = variants.find(state);
+    if (existing != variants.end())
+        return existing->second;
+
+    auto promise = std::make_shared<std::promise<std::shared_ptr<VulkanGraphicsPipeline>>>();
+    PipelineFuture future = promise->get_future().share();
+    variants.emplace(state, future);
+
+    tasks.emplace_back([this, state, promise]() {
+        try {
+            promise->set_value(std::make_shared<VulkanGraphicsPipeline>(device, state));
+        } catch (...) {
+            promise->set_exception(std::current_exception());
+        }
+    });
+    pendingCount++;
+
+    lock.unlock();
+    workAvailable.notify_one();
+
+    return future;
+}
+
+std::shared_ptr<VulkanGraphicsPipeline> VulkanPipelineManager::TryGet(const VulkanGraphicsPipelineState &state) {
+    auto future = Request(state);
+    if (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        return nullptr;
+
+    return future.get();
+}
+
+size_t VulkanPipelineManager::Evict(const std::function<bool(const VulkanGraphicsPipelineState &)> &predicate) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Queued compilations own a copy of their state and promise, so they are not affected
+    return std::erase_if(variants, [&](const auto &variant) {
+        return predicate(variant.first);
+    });
+}
+
+size_t VulkanPipelineManager::GetVariantCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return variants.size();
+}
+
+size_t VulkanPipelineManager::GetPendingCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return pendingCount;
+}
+
+void VulkanPipelineManager::WaitIdle() {
+    std::unique_lock<std::mutex> lock(mutex);
+    workDone.wait(lock, [this]() { return pendingCount == 0; });
+}
+
+void VulkanPipelineManager::WorkerLoop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            workAvailable.wait(lock, [this]() { return isStopping || !tasks.empty(); });
+
+            // Queued compilations still run on shutdown, nobody should be left waiting on a broken promise
+            if (tasks.empty())
+                return;
+
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+
+        task();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pendingCount--;
+        }
+        workDone.notify_all();
+    }
+}
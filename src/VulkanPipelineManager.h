@@ -0,0 +1,71 @@
+#pragma once
+
+#include <thread>
+#include <algorithm>
+#include <mutex>
+#include <deque>
+#include <future>
+#include <functional>
+#include <unordered_map>
+#include <condition_variable>
+
+#include "vk_common.h"
+#include "VulkanGraphicsPipeline.h"
+
+// Compiles graphics pipeline variants on a pool of worker threads. Every distinct state is compiled once,
+// requesting a state that is already queued, compiling or done returns the same future. All compilations go
+// through the device pipeline cache, which Vulkan allows to be used from several threads at once.
+class VulkanPipelineManager {
+    VK_NON_COPIABLE(VulkanPipelineManager)
+
+public:
+    using PipelineFuture = std::shared_future<std::shared_ptr<VulkanGraphicsPipeline>>;
+
+    explicit VulkanPipelineManager(std::shared_ptr<VulkanDevice> device_,
+                                   uint32_t threadCount_ = std::max(1u, std::thread::hardware_concurrency() / 2));
+
+    // Waits for the queued compilations, their pipelines may still be waited on after the manager is gone
+    ~VulkanPipelineManager();
+
+    uint32_t GetThreadCount() const;
+
+    // Queues the state for compilation unless it is already known. Compilation errors are rethrown by the future.
+    PipelineFuture Request(const VulkanGraphicsPipelineState &state);
+
+    // Returns nullptr while the variant is still compiling, so callers can draw with a fallback pipeline instead of stalling
+    std::shared_ptr<VulkanGraphicsPipeline> TryGet(const VulkanGraphicsPipelineState &state);
+
+    // Drops the cached variants the predicate selects, e.g. the ones built for a render pass that was replaced.
+    // Their pipelines stay alive while they are still referenced elsewhere. Returns the number of dropped variants.
+    size_t Evict(const std::function<bool(const VulkanGraphicsPipelineState &)> &predicate);
+
+    size_t GetVariantCount();
+
+    size_t GetPendingCount();
+
+    void WaitIdle();
+
+private:
+    void WorkerLoop();
+
+private:
+    struct StateHash {
+        size_t operator()(const VulkanGraphicsPipelineState &state) const {
+            return state.Hash();
+        }
+    };
+
+    std::shared_ptr<VulkanDevice> device;
+
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::condition_variable workDone;
+
+    std::deque<std::function<void()>> tasks;
+    size_t pendingCount = 0; // Queued and running compilations
+    bool isStopping = false;
+
+    std::unordered_map<VulkanGraphicsPipelineState, PipelineFuture, StateHash> variants;
+};
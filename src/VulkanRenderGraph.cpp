@@ -0,0 +1,576 @@
+#include "VulkanRenderGraph.h"
+
+#include <algorithm>
+
+#include "VulkanDevice.h"
+#include "VulkanInstance.h"
+#include "VulkanImage.h"
+#include "VulkanImageView.h"
+#include "VulkanRenderPass.h"
+#include "VulkanFramebuffer.h"
+#include "VulkanCommandBuffer.h"
+#include "VulkanDeletionQueue.h"
+
+static const VkAccessFlags WriteAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+                                             VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+static bool HasStencilComponent(VkFormat format) {
+    return format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT || format == VK_FORMAT_D16_UNORM_S8_UINT;
+}
+
+VulkanRenderGraphPass::VulkanRenderGraphPass(std::string name_, ExecuteCallback callback_) : name(std::move(name_)), callback(std::move(callback_)) {
+}
+
+VulkanRenderGraphPass &VulkanRenderGraphPass::AddColorOutput(VulkanRenderGraphResource resource, std::optional<VkClearColorValue> clearValue) {
+    std::optional<VkClearValue> clear;
+    if (clearValue.has_value()) {
+        clear = VkClearValue{};
+        clear->color = clearValue.value();
+    }
+
+    accesses.push_back({resource, Usage::ColorAttachment, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, clear});
+    return *this;
+}
+
+VulkanRenderGraphPass &VulkanRenderGraphPass::AddResolveOutput(VulkanRenderGraphResource resource) {
+    accesses.push_back({resource, Usage::ResolveAttachment, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, std::nullopt});
+    return *this;
+}
+
+VulkanRenderGraphPass &VulkanRenderGraphPass::SetDepthOutput(VulkanRenderGraphResource resource, std::optional<VkClearDepthStencilValue> clearValue) {
+    std::optional<VkClearValue> clear;
+    if (clearValue.has_value()) {
+        clear = VkClearValue{};
+        clear->depthStencil = clearValue.value();
+    }
+
+    accesses.push_back({resource, Usage::DepthAttachment, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, clear});
+    return *this;
+}
+
+VulkanRenderGraphPass &VulkanRenderGraphPass::AddSampledInput(VulkanRenderGraphResource resource, VkPipelineStageFlags stages) {
+    accesses.push_back({resource, Usage::Sampled, stages, std::nullopt});
+    return *this;
+}
+
+VulkanRenderGraphPass &VulkanRenderGraphPass::SetContents(VkSubpassContents contents_) {
+    contents = contents_;
+    return *this;
+}
+
+VulkanRenderGraphPass &VulkanRenderGraphPass::SetSideEffects() {
+    hasSideEffects = true;
+    return *this;
+}
+
+bool VulkanRenderGraphPass::IsCulled() const {
+    return isCulled;
+}
+
+std::shared_ptr<VulkanRenderPass> VulkanRenderGraphPass::GetRenderPass() {
+    return renderPass;
+}
+
+bool VulkanRenderGraphPass::HasAttachments() const {
+    return std::any_of(accesses.begin(), accesses.end(), [](const Access &access) { return access.usage != Usage::Sampled; });
+}
+
+VulkanRenderGraph::VulkanRenderGraph(std::shared_ptr<VulkanInstance> instance_, std::shared_ptr<VulkanDevice> device_)
+    : instance(instance_), device(device_) {
+}
+
+VulkanRenderGraph::~VulkanRenderGraph() {
+    passes.clear();
+    resources.clear();
+
+    // The images above were enqueued for destruction first, the memory they alias goes after them
+    auto memoryAllocator = device->GetMemoryAllocator();
+    for (auto &bucket: memoryBuckets) {
+        device->GetDeletionQueue()->Enqueue([memoryAllocator, allocation = bucket.allocation]() mutable {
+            memoryAllocator->Free(allocation);
+        });
+    }
+}
+
+VulkanRenderGraphResource VulkanRenderGraph::CreateImage(const std::string &name, VkExtent2D extent, VkFormat format, VkSampleCountFlagBits samples) {
+    Resource resource{};
+    resource.name = name;
+    resource.extent = extent;
+    resource.format = format;
+    resource.samples = samples;
+
+    resources.push_back(resource);
+    return static_cast<VulkanRenderGraphResource>(resources.size() - 1);
+}
+
+VulkanRenderGraphResource VulkanRenderGraph::ImportImage(const std::string &name, VkExtent2D extent, VkFormat format,
+                                                         VkImageLayout initialLayout, VkImageLayout finalLayout, VkPipelineStageFlags initialStages) {
+    Resource resource{};
+    resource.name = name;
+    resource.extent = extent;
+    resource.format = format;
+    resource.samples = VK_SAMPLE_COUNT_1_BIT;
+    resource.isImported = true;
+    resource.finalLayout = finalLayout;
+    resource.initialState.layout = initialLayout;
+    resource.initialState.stages = initialStages;
+
+    resources.push_back(resource);
+    return static_cast<VulkanRenderGraphResource>(resources.size() - 1);
+}
+
+VulkanRenderGraphPass &VulkanRenderGraph::AddPass(const std::string &name, VulkanRenderGraphPass::ExecuteCallback callback) {
+    if (isCompiled) {
+        throw std::runtime_error("render graph is already compiled!");
+    }
+
+    passes.push_back(std::unique_ptr<VulkanRenderGraphPass>(new VulkanRenderGraphPass(name, std::move(callback))));
+    return *passes.back();
+}
+
+void VulkanRenderGraph::Compile() {
+    if (isCompiled) {
+        throw std::runtime_error("render graph is already compiled!");
+    }
+
+    for (const auto &pass: passes) {
+        for (const auto &access: pass->accesses) {
+            if (access.resource >= resources.size()) {
+                throw std::runtime_error("render graph pass '" + pass->name + "' uses an unknown resource!");
+            }
+        }
+    }
+
+    CullPasses();
+    CreateTransientImages();
+    CreateRenderPasses();
+    ComputeBarriers();
+
+    isCompiled = true;
+}
+
+void VulkanRenderGraph::CullPasses() {
+    // Walk backwards from the imported resources, a pass survives if a surviving consumer needs one of its outputs
+    std::vector<bool> isNeeded(resources.size(), false);
+    for (size_t i = 0; i < resources.size(); i++)
+        isNeeded[i] = resources[i].isImported;
+
+    for (auto it = passes.rbegin(); it != passes.rend(); ++it) {
+        auto &pass = **it;
+
+        bool writesNeededResource = std::any_of(pass.accesses.begin(), pass.accesses.end(), [&](const VulkanRenderGraphPass::Access &access) {
+            return IsWrite(access.usage) && isNeeded[access.resource];
+        });
+        pass.isCulled = !pass.hasSideEffects && !writesNeededResource;
+        if (pass.isCulled)
+            continue;
+
+        // Attachments that aren't cleared may be loaded, so their earlier writers are needed as well
+        for (const auto &access: pass.accesses) {
+            if (!IsWrite(access.usage) || (access.usage != VulkanRenderGraphPass::Usage::ResolveAttachment && !access.clearValue.has_value()))
+                isNeeded[access.resource] = true;
+        }
+    }
+}
+
+void VulkanRenderGraph::CreateTransientImages() {
+    for (int passIndex = 0; passIndex < static_cast<int>(passes.size()); passIndex++) {
+        const auto &pass = *passes[passIndex];
+        if (pass.isCulled)
+            continue;
+
+        for (const auto &access: pass.accesses) {
+            auto &resource = resources[access.resource];
+            if (resource.firstPass < 0)
+                resource.firstPass = passIndex;
+            resource.lastPass = passIndex;
+
+            switch (access.usage) {
+                case VulkanRenderGraphPass::Usage::ColorAttachment:
+                case VulkanRenderGraphPass::Usage::ResolveAttachment:
+                    resource.usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+                    break;
+                case VulkanRenderGraphPass::Usage::DepthAttachment:
+                    resource.usage |= VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+                    resource.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+                    break;
+                case VulkanRenderGraphPass::Usage::Sampled:
+                    resource.usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+                    break;
+            }
+        }
+    }
+
+    // Largest images first, so the smaller ones fill the gaps between them
+    std::vector<VulkanRenderGraphResource> transientResources;
+    std::vector<VkMemoryRequirements> requirements(resources.size());
+    for (VulkanRenderGraphResource i = 0; i < resources.size(); i++) {
+        auto &resource = resources[i];
+        if (resource.isImported || resource.firstPass < 0)
+            continue;
+
+        // Images that are never sampled don't need their content outside of the render passes
+        if ((resource.usage & VK_IMAGE_USAGE_SAMPLED_BIT) == 0)
+            resource.usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+
+        resource.image = std::make_shared<VulkanImage>(instance, device, resource.extent.width, resource.extent.height, resource.samples,
+                                                       resource.format, resource.usage);
+        requirements[i] = resource.image->GetMemoryRequirements();
+        transientResources.push_back(i);
+    }
+    std::stable_sort(transientResources.begin(), transientResources.end(), [&](VulkanRenderGraphResource a, VulkanRenderGraphResource b) {
+        return requirements[a].size > requirements[b].size;
+    });
+
+    for (VulkanRenderGraphResource i: transientResources) {
+        const auto &requirement = requirements[i];
+
+        auto bucket = std::find_if(memoryBuckets.begin(), memoryBuckets.end(), [&](const MemoryBucket &candidate) {
+            return (candidate.memoryTypeBits & requirement.memoryTypeBits) != 0;
+        });
+        if (bucket == memoryBuckets.end()) {
+            memoryBuckets.push_back({requirement.memoryTypeBits});
+            bucket = memoryBuckets.end() - 1;
+        }
+
+        VkDeviceSize offset = FindAliasOffset(*bucket, i, requirement);
+        bucket->memoryTypeBits &= requirement.memoryTypeBits;
+        bucket->alignment = std::max(bucket->alignment, requirement.alignment);
+        bucket->size = std::max(bucket->size, offset + requirement.size);
+        bucket->placements.push_back({i, offset, requirement.size});
+
+        for (const auto &pass: passes) {
+            for (const auto &access: pass->accesses) {
+                if (pass->isCulled || access.resource != i)
+                    continue;
+
+                ImageState state = GetAccessState(access);
+                bucket->writeAccessMask |= state.accessMask & WriteAccessMask;
+                bucket->stages |= state.stages;
+            }
+        }
+    }
+
+    for (auto &bucket: memoryBuckets) {
+        VkMemoryRequirements bucketRequirements{};
+        bucketRequirements.size = bucket.size;
+        bucketRequirements.alignment = bucket.alignment;
+        bucketRequirements.memoryTypeBits = bucket.memoryTypeBits;
+        bucket.allocation = device->GetMemoryAllocator()->Allocate(bucketRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, false,
+                                                                   VulkanMemoryCategory::Attachment);
+
+        for (const auto &placement: bucket.placements) {
+            auto &resource = resources[placement.resource];
+            resource.image->BindMemory(bucket.allocation.memory, bucket.allocation.offset + placement.offset);
+            resource.imageView = resource.image->GetView(resource.format, resource.aspectMask);
+
+            // The previous occupant of the memory may be used by any pass of the bucket, including ones of the previous frame
+            resource.initialState.accessMask = bucket.writeAccessMask;
+            resource.initialState.stages = bucket.stages;
+        }
+    }
+}
+
+VkDeviceSize VulkanRenderGraph::FindAliasOffset(const MemoryBucket &bucket, VulkanRenderGraphResource resource, const VkMemoryRequirements &requirements) {
+    const auto &placed = resources[resource];
+
+    // Only images that are alive at the same time as this one block memory
+    std::vector<MemoryPlacement> blocking;
+    for (const auto &placement: bucket.placements) {
+        const auto &other = resources[placement.resource];
+        if (other.firstPass <= placed.lastPass && placed.firstPass <= other.lastPass)
+            blocking.push_back(placement);
+    }
+    std::sort(blocking.begin(), blocking.end(), [](const MemoryPlacement &a, const MemoryPlacement &b) { return a.offset < b.offset; });
+
+    VkDeviceSize offset = 0;
+    for (const auto &placement: blocking) {
+        if (offset + requirements.size <= placement.offset)
+            break;
+
+        VkDeviceSize end = placement.offset + placement.size;
+        offset = std::max(offset, (end + requirements.alignment - 1) / requirements.alignment * requirements.alignment);
+    }
+
+    return offset;
+}
+
+void VulkanRenderGraph::CreateRenderPasses() {
+    for (int passIndex = 0; passIndex < static_cast<int>(passes.size()); passIndex++) {
+        auto &pass = *passes[passIndex];
+        if (pass.isCulled || !pass.HasAttachments())
+            continue;
+
+        // Attachment order: color outputs, resolve outputs, depth output
+        std::vector<const VulkanRenderGraphPass::Access *> orderedAccesses;
+        for (auto usage: {VulkanRenderGraphPass::Usage::ColorAttachment, VulkanRenderGraphPass::Usage::ResolveAttachment,
+                          VulkanRenderGraphPass::Usage::DepthAttachment}) {
+            for (const auto &access: pass.accesses) {
+                if (access.usage == usage)
+                    orderedAccesses.push_back(&access);
+            }
+        }
+
+        std::vector<VkAttachmentDescription> attachments;
+        std::vector<VkClearValue> clearValues;
+        std::vector<uint32_t> colorAttachments;
+        std::vector<uint32_t> resolveAttachments;
+        std::optional<uint32_t> depthAttachment;
+        VkExtent2D extent = resources[orderedAccesses.front()->resource].extent;
+
+        for (const auto *access: orderedAccesses) {
+            const auto &resource = resources[access->resource];
+            if (resource.extent.width != extent.width || resource.extent.height != extent.height) {
+                throw std::runtime_error("attachments of render graph pass '" + pass.name + "' differ in size!");
+            }
+
+            ImageState state = GetAccessState(*access);
+            bool hasContent = HasEarlierWriter(access->resource, passIndex) ||
+                              (resource.isImported && resource.initialState.layout != VK_IMAGE_LAYOUT_UNDEFINED);
+
+            VkAttachmentDescription attachment{};
+            attachment.format = resource.format;
+            attachment.samples = resource.samples;
+            if (access->clearValue.has_value())
+                attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+            else if (hasContent && access->usage != VulkanRenderGraphPass::Usage::ResolveAttachment)
+                attachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+            else
+                attachment.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            attachment.storeOp = (resource.isImported || HasLaterAccess(access->resource, passIndex))
+                                 ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            if (HasStencilComponent(resource.format)) {
+                attachment.stencilLoadOp = attachment.loadOp;
+                attachment.stencilStoreOp = attachment.storeOp;
+            }
+
+            // The transitions happen in the barriers in front of the pass, not in the render pass itself
+            attachment.initialLayout = state.layout;
+            attachment.finalLayout = state.layout;
+
+            uint32_t attachmentIndex = static_cast<uint32_t>(attachments.size());
+            switch (access->usage) {
+                case VulkanRenderGraphPass::Usage::ColorAttachment:
+                    colorAttachments.push_back(attachmentIndex);
+                    break;
+                case VulkanRenderGraphPass::Usage::ResolveAttachment:
+                    resolveAttachments.push_back(attachmentIndex);
+                    break;
+                case VulkanRenderGraphPass::Usage::DepthAttachment:
+                    if (depthAttachment.has_value()) {
+                        throw std::runtime_error("render graph pass '" + pass.name + "' has more than one depth output!");
+                    }
+                    depthAttachment = attachmentIndex;
+                    break;
+                default:
+                    break;
+            }
+
+            attachments.push_back(attachment);
+            clearValues.push_back(access->clearValue.value_or(VkClearValue{}));
+            pass.attachments.push_back(access->resource);
+        }
+
+        pass.renderPass = std::make_shared<VulkanRenderPass>(instance, device, attachments, colorAttachments, resolveAttachments,
+                                                             depthAttachment, clearValues);
+    }
+}
+
+void VulkanRenderGraph::ComputeBarriers() {
+    std::vector<ImageState> states;
+    for (const auto &resource: resources)
+        states.push_back(resource.initialState);
+
+    for (auto &pass: passes) {
+        if (pass->isCulled)
+            continue;
+
+        for (const auto &access: pass->accesses) {
+            ImageState &current = states[access.resource];
+            ImageState required = GetAccessState(access);
+
+            // Read after read needs no barrier, everything else does
+            bool isLayoutChange = current.layout != required.layout;
+            bool isHazard = (current.accessMask & WriteAccessMask) != 0 || (required.accessMask & WriteAccessMask) != 0;
+            if (isLayoutChange || isHazard) {
+                pass->barrier.transitions.push_back({access.resource, current.layout, required.layout,
+                                                     current.accessMask & WriteAccessMask, required.accessMask});
+                pass->barrier.srcStages |= current.stages;
+                pass->barrier.dstStages |= required.stages;
+                current = required;
+            } else {
+                current.accessMask |= required.accessMask;
+                current.stages |= required.stages;
+            }
+        }
+    }
+
+    for (VulkanRenderGraphResource i = 0; i < resources.size(); i++) {
+        const auto &resource = resources[i];
+        if (!resource.isImported || resource.firstPass < 0 || resource.finalLayout == VK_IMAGE_LAYOUT_UNDEFINED ||
+            resource.finalLayout == states[i].layout)
+            continue;
+
+        finalBarrier.transitions.push_back({i, states[i].layout, resource.finalLayout, states[i].accessMask & WriteAccessMask, 0});
+        finalBarrier.srcStages |= states[i].stages;
+        finalBarrier.dstStages |= VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+    }
+}
+
+bool VulkanRenderGraph::HasEarlierWriter(VulkanRenderGraphResource resource, int passIndex) {
+    for (int i = 0; i < passIndex; i++) {
+        if (passes[i]->isCulled)
+            continue;
+
+        for (const auto &access: passes[i]->accesses) {
+            if (access.resource == resource && IsWrite(access.usage))
+                return true;
+        }
+    }
+
+    return false;
+}
+
+bool VulkanRenderGraph::HasLaterAccess(VulkanRenderGraphResource resource, int passIndex) {
+    for (int i = passIndex + 1; i < static_cast<int>(passes.size()); i++) {
+        if (passes[i]->isCulled)
+            continue;
+
+        for (const auto &access: passes[i]->accesses) {
+            if (access.resource == resource)
+                return true;
+        }
+    }
+
+    return false;
+}
+
+void VulkanRenderGraph::SetImportedImage(VulkanRenderGraphResource resource, std::shared_ptr<VulkanImageView> imageView) {
+    if (!resources.at(resource).isImported) {
+        throw std::runtime_error("render graph resource '" + resources[resource].name + "' is not imported!");
+    }
+
+    resources[resource].imageView = imageView;
+    resources[resource].image = imageView->GetImage();
+}
+
+void VulkanRenderGraph::Execute(std::shared_ptr<VulkanCommandBuffer> commandBuffer) {
+    if (!isCompiled) {
+        throw std::runtime_error("render graph has to be compiled before execution!");
+    }
+
+    for (auto &pass: passes) {
+        if (pass->isCulled)
+            continue;
+
+        RecordBarrier(commandBuffer, pass->barrier);
+
+        VulkanRenderGraphContext context{};
+        context.commandBuffer = commandBuffer;
+        if (pass->renderPass != nullptr) {
+            context.renderPass = pass->renderPass;
+            context.framebuffer = GetFramebuffer(*pass);
+
+            pass->renderPass->Begin(commandBuffer, context.framebuffer, pass->contents);
+            pass->callback(context);
+            pass->renderPass->End(commandBuffer);
+        } else {
+            pass->callback(context);
+        }
+    }
+
+    RecordBarrier(commandBuffer, finalBarrier);
+}
+
+void VulkanRenderGraph::RecordBarrier(std::shared_ptr<VulkanCommandBuffer> commandBuffer, const VulkanRenderGraphPass::Barrier &barrier) {
+    if (barrier.transitions.empty())
+        return;
+
+    std::vector<VkImageMemoryBarrier2> imageBarriers;
+    for (const auto &transition: barrier.transitions) {
+        const auto &resource = resources[transition.resource];
+        if (resource.image == nullptr) {
+            throw std::runtime_error("render graph resource '" + resource.name + "' has no image assigned!");
+        }
+
+        VkImageMemoryBarrier2 imageBarrier{};
+        imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+        imageBarrier.srcStageMask = barrier.srcStages;
+        imageBarrier.dstStageMask = barrier.dstStages;
+        imageBarrier.oldLayout = transition.oldLayout;
+        imageBarrier.newLayout = transition.newLayout;
+        imageBarrier.srcAccessMask = transition.srcAccessMask;
+        imageBarrier.dstAccessMask = transition.dstAccessMask;
+        imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imageBarrier.image = resource.image->Handle();
+        imageBarrier.subresourceRange.aspectMask = resource.aspectMask;
+        if (resource.aspectMask == VK_IMAGE_ASPECT_DEPTH_BIT && HasStencilComponent(resource.format))
+            imageBarrier.subresourceRange.aspectMask |= VK_IMAGE_ASPECT_STENCIL_BIT;
+        imageBarrier.subresourceRange.baseMipLevel = 0;
+        imageBarrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+        imageBarrier.subresourceRange.baseArrayLayer = 0;
+        imageBarrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+        imageBarriers.push_back(imageBarrier);
+    }
+
+    VkDependencyInfo dependencyInfo{};
+    dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+    dependencyInfo.imageMemoryBarrierCount = static_cast<uint32_t>(imageBarriers.size());
+    dependencyInfo.pImageMemoryBarriers = imageBarriers.data();
+    vkCmdPipelineBarrier2(commandBuffer->Handle(), &dependencyInfo);
+}
+
+std::shared_ptr<VulkanFramebuffer> VulkanRenderGraph::GetFramebuffer(VulkanRenderGraphPass &pass) {
+    std::vector<VkImageView> viewHandles;
+    std::vector<std::shared_ptr<VulkanImageView>> views;
+    for (VulkanRenderGraphResource attachment: pass.attachments) {
+        const auto &resource = resources[attachment];
+        if (resource.imageView == nullptr) {
+            throw std::runtime_error("render graph resource '" + resource.name + "' has no image assigned!");
+        }
+
+        viewHandles.push_back(resource.imageView->Handle());
+        views.push_back(resource.imageView);
+    }
+
+    auto match = pass.framebuffers.find(viewHandles);
+    if (match != pass.framebuffers.end())
+        return match->second;
+
+    auto framebuffer = std::make_shared<VulkanFramebuffer>(device, pass.renderPass, views, resources[pass.attachments.front()].extent);
+    pass.framebuffers[viewHandles] = framebuffer;
+    return framebuffer;
+}
+
+std::shared_ptr<VulkanImageView> VulkanRenderGraph::GetImageView(VulkanRenderGraphResource resource) {
+    return resources.at(resource).imageView;
+}
+
+VkDeviceSize VulkanRenderGraph::GetTransientMemorySize() const {
+    VkDeviceSize size = 0;
+    for (const auto &bucket: memoryBuckets)
+        size += bucket.size;
+    return size;
+}
+
+VulkanRenderGraph::ImageState VulkanRenderGraph::GetAccessState(const VulkanRenderGraphPass::Access &access) {
+    switch (access.usage) {
+        case VulkanRenderGraphPass::Usage::ColorAttachment:
+        case VulkanRenderGraphPass::Usage::ResolveAttachment:
+            return {VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, access.stages};
+        case VulkanRenderGraphPass::Usage::DepthAttachment:
+            return {VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+                    VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, access.stages};
+        case VulkanRenderGraphPass::Usage::Sampled:
+            return {VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_SHADER_READ_BIT, access.stages};
+    }
+
+    throw std::runtime_error("unknown render graph resource usage!");
+}
+
+bool VulkanRenderGraph::IsWrite(VulkanRenderGraphPass::Usage usage) {
+    return usage != VulkanRenderGraphPass::Usage::Sampled;
+}
@@ -0,0 +1,214 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <optional>
+#include <functional>
+
+#include "vk_common.h"
+#include "VulkanMemoryAllocator.h"
+
+using VulkanRenderGraphResource = uint32_t;
+
+struct VulkanRenderGraphContext {
+    std::shared_ptr<VulkanCommandBuffer> commandBuffer;
+
+    // Both null for passes without attachments
+    std::shared_ptr<VulkanRenderPass> renderPass;
+    std::shared_ptr<VulkanFramebuffer> framebuffer;
+};
+
+// Declares which graph resources a pass reads and writes. The graph derives the render pass,
+// load/store operations and every barrier of the pass from these declarations.
+class VulkanRenderGraphPass {
+    VK_NON_COPIABLE(VulkanRenderGraphPass)
+
+public:
+    using ExecuteCallback = std::function<void(const VulkanRenderGraphContext &context)>;
+
+    // Outputs are loaded when an earlier pass wrote them, cleared when a clear value is given and discarded otherwise
+    VulkanRenderGraphPass &AddColorOutput(VulkanRenderGraphResource resource, std::optional<VkClearColorValue> clearValue = std::nullopt);
+
+    // Multisampled color outputs are resolved into these, in the order of the color outputs
+    VulkanRenderGraphPass &AddResolveOutput(VulkanRenderGraphResource resource);
+
+    VulkanRenderGraphPass &SetDepthOutput(VulkanRenderGraphResource resource, std::optional<VkClearDepthStencilValue> clearValue = std::nullopt);
+
+    VulkanRenderGraphPass &AddSampledInput(VulkanRenderGraphResource resource, VkPipelineStageFlags stages = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+
+    // Passes that execute secondary command buffers inside their render pass instance
+    VulkanRenderGraphPass &SetContents(VkSubpassContents contents_);
+
+    // Keeps the pass even if none of its outputs are consumed
+    VulkanRenderGraphPass &SetSideEffects();
+
+    bool IsCulled() const;
+
+    // Valid after VulkanRenderGraph::Compile(), pipelines of the pass have to be created against it
+    std::shared_ptr<VulkanRenderPass> GetRenderPass();
+
+private:
+    friend class VulkanRenderGraph;
+
+    enum class Usage {
+        ColorAttachment,
+        ResolveAttachment,
+        DepthAttachment,
+        Sampled
+    };
+
+    struct Access {
+        VulkanRenderGraphResource resource;
+        Usage usage;
+        VkPipelineStageFlags stages;
+        std::optional<VkClearValue> clearValue;
+    };
+
+    struct Transition {
+        VulkanRenderGraphResource resource;
+        VkImageLayout oldLayout;
+        VkImageLayout newLayout;
+        VkAccessFlags srcAccessMask;
+        VkAccessFlags dstAccessMask;
+    };
+
+    struct Barrier {
+        std::vector<Transition> transitions;
+        VkPipelineStageFlags srcStages = 0;
+        VkPipelineStageFlags dstStages = 0;
+    };
+
+    VulkanRenderGraphPass(std::string name_, ExecuteCallback callback_);
+
+    bool HasAttachments() const;
+
+private:
+    std::string name;
+    ExecuteCallback callback;
+    std::vector<Access> accesses;
+    VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE;
+    bool hasSideEffects = false;
+
+    // Compiled state
+    bool isCulled = false;
+    Barrier barrier;
+    std::shared_ptr<VulkanRenderPass> renderPass;
+    std::vector<VulkanRenderGraphResource> attachments;
+    std::map<std::vector<VkImageView>, std::shared_ptr<VulkanFramebuffer>> framebuffers;
+};
+
+// Frame graph over the image resources of a frame. Passes are declared in execution order together
+// with the resources they read and write, then Compile() culls the passes that contribute nothing to
+// an imported resource, creates a render pass per pass and precomputes the layout transitions.
+//
+// Graph-created (transient) images only live for the duration of the frame. Images whose pass
+// ranges don't overlap are placed into the same memory, so intermediate targets of different
+// passes share one allocation.
+class VulkanRenderGraph {
+    VK_NON_COPIABLE(VulkanRenderGraph)
+
+public:
+    VulkanRenderGraph(std::shared_ptr<VulkanInstance> instance_, std::shared_ptr<VulkanDevice> device_);
+
+    ~VulkanRenderGraph();
+
+    VulkanRenderGraphResource CreateImage(const std::string &name, VkExtent2D extent, VkFormat format, VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT);
+
+    // Images that live outside the graph, like the swap chain images. Their content is kept unless the initial
+    // layout is undefined, and they are left in the final layout. The initial stages have to cover whatever
+    // made the image available, e.g. the color attachment output stage the acquire semaphore is waited on.
+    VulkanRenderGraphResource ImportImage(const std::string &name, VkExtent2D extent, VkFormat format,
+                                          VkImageLayout initialLayout, VkImageLayout finalLayout,
+                                          VkPipelineStageFlags initialStages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+
+    VulkanRenderGraphPass &AddPass(const std::string &name, VulkanRenderGraphPass::ExecuteCallback callback);
+
+    void Compile();
+
+    // Imported images may change between executions, every combination gets its own cached framebuffers
+    void SetImportedImage(VulkanRenderGraphResource resource, std::shared_ptr<VulkanImageView> imageView);
+
+    void Execute(std::shared_ptr<VulkanCommandBuffer> commandBuffer);
+
+    std::shared_ptr<VulkanImageView> GetImageView(VulkanRenderGraphResource resource);
+
+    // Memory taken by the transient images after aliasing
+    VkDeviceSize GetTransientMemorySize() const;
+
+private:
+    struct ImageState {
+        VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkAccessFlags accessMask = 0;
+        VkPipelineStageFlags stages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    };
+
+    struct Resource {
+        std::string name;
+        VkExtent2D extent;
+        VkFormat format;
+        VkSampleCountFlagBits samples;
+
+        bool isImported = false;
+        VkImageLayout finalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        ImageState initialState;
+
+        // Compiled state
+        int firstPass = -1;
+        int lastPass = -1;
+        VkImageUsageFlags usage = 0;
+        VkImageAspectFlags aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        std::shared_ptr<VulkanImage> image;
+        std::shared_ptr<VulkanImageView> imageView;
+    };
+
+    struct MemoryPlacement {
+        VulkanRenderGraphResource resource;
+        VkDeviceSize offset;
+        VkDeviceSize size;
+    };
+
+    struct MemoryBucket {
+        uint32_t memoryTypeBits = 0;
+        VkDeviceSize alignment = 1;
+        VkDeviceSize size = 0;
+        std::vector<MemoryPlacement> placements{};
+        VulkanMemoryAllocation allocation{};
+
+        // Every access of the images in the bucket, a new occupant has to wait for all of them
+        VkAccessFlags writeAccessMask = 0;
+        VkPipelineStageFlags stages = 0;
+    };
+
+    void CullPasses();
+
+    void CreateTransientImages();
+
+    VkDeviceSize FindAliasOffset(const MemoryBucket &bucket, VulkanRenderGraphResource resource, const VkMemoryRequirements &requirements);
+
+    void CreateRenderPasses();
+
+    void ComputeBarriers();
+
+    bool HasEarlierWriter(VulkanRenderGraphResource resource, int passIndex);
+
+    bool HasLaterAccess(VulkanRenderGraphResource resource, int passIndex);
+
+    void RecordBarrier(std::shared_ptr<VulkanCommandBuffer> commandBuffer, const VulkanRenderGraphPass::Barrier &barrier);
+
+    std::shared_ptr<VulkanFramebuffer> GetFramebuffer(VulkanRenderGraphPass &pass);
+
+    static ImageState GetAccessState(const VulkanRenderGraphPass::Access &access);
+
+    static bool IsWrite(VulkanRenderGraphPass::Usage usage);
+
+private:
+    std::shared_ptr<VulkanInstance> instance;
+    std::shared_ptr<VulkanDevice> device;
+
+private:
+    std::vector<Resource> resources;
+    std::vector<std::unique_ptr<VulkanRenderGraphPass>> passes;
+    std::vector<MemoryBucket> memoryBuckets;
+    VulkanRenderGraphPass::Barrier finalBarrier;
+    bool isCompiled = false;
+};
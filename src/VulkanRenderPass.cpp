@@ -1,12 +1,14 @@
 #include "VulkanRenderPass.h"
 
 #include <array>
+#include <functional>
 
 #include "VulkanInstance.h"
 #include "VulkanSwapChain.h"
 #include "VulkanDevice.h"
 #include "VulkanCommandBuffer.h"
 #include "VulkanFramebuffer.h"
+#include "VulkanDeletionQueue.h"
 
 VulkanRenderPass::VulkanRenderPass(std::shared_ptr<VulkanInstance> instance_, std::shared_ptr<VulkanDevice> device_, std::shared_ptr<VulkanSwapChain> swapChain_)
     : device(device_), swapChain(swapChain_), instance(instance_) {
@@ -80,49 +82,118 @@ VulkanRenderPass::VulkanRenderPass(std::shared_ptr<VulkanInstance> instance_, st
     if (vkCreateRenderPass(device->Handle(), &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
         throw std::runtime_error("failed to create render pass!");
     }
+
+    colorSignatures = {{colorAttachment.format, colorAttachment.samples}};
+    resolveSignatures = {{colorAttachmentResolve.format, colorAttachmentResolve.samples}};
+    depthSignature = {depthAttachment.format, depthAttachment.samples};
+
+    // Configure how the screen will be cleared before the Render Pass begins
+    clearValues.resize(2);
+    clearValues[0].color = {{0.0f, 0.0f, 0.0f, 1.0f}};
+    clearValues[1].depthStencil = {1.0f, 0};
+}
+
+VulkanRenderPass::VulkanRenderPass(std::shared_ptr<VulkanInstance> instance_, std::shared_ptr<VulkanDevice> device_,
+                                   const std::vector<VkAttachmentDescription> &attachments, const std::vector<uint32_t> &colorAttachments,
+                                   const std::vector<uint32_t> &resolveAttachments, std::optional<uint32_t> depthAttachment,
+                                   std::vector<VkClearValue> clearValues_)
+    : instance(instance_), device(device_), clearValues(clearValues_) {
+    std::vector<VkAttachmentReference> colorAttachmentRefs;
+    for (uint32_t attachment: colorAttachments)
+        colorAttachmentRefs.push_back({attachment, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL});
+
+    std::vector<VkAttachmentReference> resolveAttachmentRefs;
+    for (uint32_t attachment: resolveAttachments)
+        resolveAttachmentRefs.push_back({attachment, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL});
+
+    VkAttachmentReference depthAttachmentRef{};
+    if (depthAttachment.has_value())
+        depthAttachmentRef = {depthAttachment.value(), VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
+
+    if (!resolveAttachmentRefs.empty() && resolveAttachmentRefs.size() != colorAttachmentRefs.size()) {
+        throw std::invalid_argument("every color attachment needs a resolve attachment!");
+    }
+
+    VkSubpassDescription subpass{};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = static_cast<uint32_t>(colorAttachmentRefs.size());
+    subpass.pColorAttachments = colorAttachmentRefs.data();
+    subpass.pResolveAttachments = resolveAttachmentRefs.empty() ? nullptr : resolveAttachmentRefs.data();
+    subpass.pDepthStencilAttachment = depthAttachment.has_value() ? &depthAttachmentRef : nullptr;
+
+    VkRenderPassCreateInfo renderPassInfo{};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+    renderPassInfo.pAttachments = attachments.data();
+    renderPassInfo.subpassCount = 1;
+    renderPassInfo.pSubpasses = &subpass;
+
+    if (vkCreateRenderPass(device->Handle(), &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create render pass!");
+    }
+
+    for (uint32_t attachment: colorAttachments)
+        colorSignatures.emplace_back(attachments[attachment].format, attachments[attachment].samples);
+    for (uint32_t attachment: resolveAttachments)
+        resolveSignatures.emplace_back(attachments[attachment].format, attachments[attachment].samples);
+    if (depthAttachment.has_value())
+        depthSignature = {attachments[depthAttachment.value()].format, attachments[depthAttachment.value()].samples};
 }
 
 VkFormat VulkanRenderPass::FindDepthFormat() {
-    return FindSupportedFormat(
-        {VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT},
-        VK_IMAGE_TILING_OPTIMAL,
-        VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT
-    );
+    return instance->FindDepthFormat();
+}
+
+bool VulkanRenderPass::IsCompatibleWith(const VulkanRenderPass &other) const {
+    return colorSignatures == other.colorSignatures && resolveSignatures == other.resolveSignatures && depthSignature == other.depthSignature;
 }
 
-VkFormat VulkanRenderPass::FindSupportedFormat(const std::vector<VkFormat> &candidates, VkImageTiling tiling, VkFormatFeatureFlags features) {
-    for (VkFormat format: candidates) {
-        VkFormatProperties props;
-        vkGetPhysicalDeviceFormatProperties(instance->PhysicalDeviceHandle(), format, &props);
+size_t VulkanRenderPass::GetCompatibilityHash() const {
+    size_t seed = 0;
+    auto combine = [&seed](const AttachmentSignature &signature) {
+        seed ^= std::hash<uint64_t>()((static_cast<uint64_t>(signature.first) << 32) | signature.second) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    };
+
+    for (const auto &signature: colorSignatures)
+        combine(signature);
+    seed ^= resolveSignatures.size() << 16;
+    for (const auto &signature: resolveSignatures)
+        combine(signature);
+    if (depthSignature.has_value())
+        combine(depthSignature.value());
+
+    return seed;
+}
 
-        if (tiling == VK_IMAGE_TILING_LINEAR && (props.linearTilingFeatures & features) == features) {
-            return format;
-        } else if (tiling == VK_IMAGE_TILING_OPTIMAL && (props.optimalTilingFeatures & features) == features) {
-            return format;
-        }
-    }
+VkSampleCountFlagBits VulkanRenderPass::GetSampleCount() const {
+    if (!colorSignatures.empty())
+        return colorSignatures.front().second;
+    if (depthSignature.has_value())
+        return depthSignature->second;
 
-    throw std::runtime_error("failed to find supported format!");
+    return VK_SAMPLE_COUNT_1_BIT;
 }
 
-void VulkanRenderPass::Begin(std::shared_ptr<VulkanCommandBuffer> commandBuffer, std::shared_ptr<VulkanFramebuffer> framebuffer) {
+void VulkanRenderPass::Begin(std::shared_ptr<VulkanCommandBuffer> commandBuffer, std::shared_ptr<VulkanFramebuffer> framebuffer, VkSubpassContents contents) {
     VkRenderPassBeginInfo renderPassInfo{};
     renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
     renderPassInfo.renderPass = renderPass;
     renderPassInfo.framebuffer = framebuffer->Handle();
     renderPassInfo.renderArea.offset = {0, 0};
-    renderPassInfo.renderArea.extent = swapChain->GetExtent();
-
-    // Configure how the screen will be cleared before the Render Pass begins
-    std::array<VkClearValue, 2> clearValues{};
-    clearValues[0].color = {{0.0f, 0.0f, 0.0f, 1.0f}};
-    clearValues[1].depthStencil = {1.0f, 0};
+    renderPassInfo.renderArea.extent = framebuffer->GetExtent();
     renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
     renderPassInfo.pClearValues = clearValues.data();
 
-    vkCmdBeginRenderPass(commandBuffer->Handle(), &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+    vkCmdBeginRenderPass(commandBuffer->Handle(), &renderPassInfo, contents);
 }
 
 void VulkanRenderPass::End(std::shared_ptr<VulkanCommandBuffer> commandBuffer) {
     vkCmdEndRenderPass(commandBuffer->Handle());
 }
+
+VulkanRenderPass::~VulkanRenderPass() {
+    VkDevice deviceHandle = device->Handle();
+    device->GetDeletionQueue()->Enqueue([deviceHandle, renderPass = renderPass]() mutable {
+        VkDestroy(vkDestroyRenderPass, deviceHandle, renderPass);
+    });
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <optional>
+
 #include "vk_common.h"
 
 class VulkanRenderPass {
@@ -8,19 +10,44 @@ class VulkanRenderPass {
 public:
     VulkanRenderPass(std::shared_ptr<VulkanInstance> instance_, std::shared_ptr<VulkanDevice> device_, std::shared_ptr<VulkanSwapChain> swapChain_);
 
+    // Single subpass render pass over arbitrary attachments, the attachment descriptions carry the load/store operations
+    // and layouts. Resolve attachments are either empty or match the color attachments one by one.
+    VulkanRenderPass(std::shared_ptr<VulkanInstance> instance_, std::shared_ptr<VulkanDevice> device_,
+                     const std::vector<VkAttachmentDescription> &attachments, const std::vector<uint32_t> &colorAttachments,
+                     const std::vector<uint32_t> &resolveAttachments, std::optional<uint32_t> depthAttachment,
+                     std::vector<VkClearValue> clearValues_);
+
+    ~VulkanRenderPass();
+
     VkFormat FindDepthFormat();
 
-    void Begin(std::shared_ptr<VulkanCommandBuffer> commandBuffer, std::shared_ptr<VulkanFramebuffer> framebuffer);
-    void End(std::shared_ptr<VulkanCommandBuffer> commandBuffer);
+    // Pipelines created against one render pass can be used with every compatible one
+    bool IsCompatibleWith(const VulkanRenderPass &other) const;
 
-private:
-    VkFormat FindSupportedFormat(const std::vector<VkFormat> &candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
+    // Equal for compatible render passes
+    size_t GetCompatibilityHash() const;
+
+    // Sample count pipelines of the subpass have to rasterize with
+    VkSampleCountFlagBits GetSampleCount() const;
+
+    void Begin(std::shared_ptr<VulkanCommandBuffer> commandBuffer, std::shared_ptr<VulkanFramebuffer> framebuffer,
+               VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
+    void End(std::shared_ptr<VulkanCommandBuffer> commandBuffer);
 
 private:
     std::shared_ptr<VulkanInstance> instance;
     std::shared_ptr<VulkanDevice> device;
     std::shared_ptr<VulkanSwapChain> swapChain;
 
+private:
+    std::vector<VkClearValue> clearValues;
+
+    // Format and sample count of every attachment reference, which is all that render pass compatibility depends on
+    using AttachmentSignature = std::pair<VkFormat, VkSampleCountFlagBits>;
+    std::vector<AttachmentSignature> colorSignatures;
+    std::vector<AttachmentSignature> resolveSignatures;
+    std::optional<AttachmentSignature> depthSignature;
+
 private:
 VK_HANDLE(VkRenderPass, renderPass);
 };
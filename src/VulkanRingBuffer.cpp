@@ -0,0 +1,65 @@
+#include "VulkanRingBuffer.h"
+
+#include <algorithm>
+
+#include "VulkanDevice.h"
+#include "VulkanInstance.h"
+#include "VulkanBuffer.h"
+
+static VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+VulkanRingBuffer::VulkanRingBuffer(std::shared_ptr<VulkanDevice> device_, std::shared_ptr<VulkanInstance> instance_,
+                                   VkDeviceSize frameSize_, uint32_t frameCount_, VkBufferUsageFlags usage)
+    : device(device_), instance(instance_), frameCount(frameCount_) {
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(instance->PhysicalDeviceHandle(), &properties);
+
+    if (usage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT)
+        alignment = std::max(alignment, properties.limits.minUniformBufferOffsetAlignment);
+    if (usage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)
+        alignment = std::max(alignment, properties.limits.minStorageBufferOffsetAlignment);
+
+    // Every partition has to start on an aligned offset as well
+    frameSize = AlignUp(frameSize_, alignment);
+
+    buffer = std::make_shared<VulkanBuffer>(device, instance, frameSize * frameCount, usage,
+                                            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    mappedData = static_cast<uint8_t *>(buffer->GetMappedData());
+}
+
+void VulkanRingBuffer::BeginFrame(uint32_t frameIndex) {
+    currentFrame = frameIndex % frameCount;
+    head = 0;
+}
+
+VulkanRingAllocation VulkanRingBuffer::Allocate(VkDeviceSize size) {
+    VkDeviceSize offset = AlignUp(head, alignment);
+    if (offset + size > frameSize) {
+        throw std::runtime_error("ring buffer frame partition is full!");
+    }
+    head = offset + size;
+
+    VulkanRingAllocation allocation{};
+    allocation.offset = static_cast<uint32_t>(currentFrame * frameSize + offset);
+    allocation.data = mappedData + allocation.offset;
+    return allocation;
+}
+
+void VulkanRingBuffer::Flush() {
+    buffer->MarkDirty(currentFrame * frameSize, head);
+    buffer->Flush();
+}
+
+std::shared_ptr<VulkanBuffer> VulkanRingBuffer::GetBuffer() {
+    return buffer;
+}
+
+VkDeviceSize VulkanRingBuffer::GetAlignment() const {
+    return alignment;
+}
+
+VkDeviceSize VulkanRingBuffer::GetFrameSize() const {
+    return frameSize;
+}
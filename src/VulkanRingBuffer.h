@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstring>
+
+#include "vk_common.h"
+
+struct VulkanRingAllocation {
+    void *data = nullptr;
+    uint32_t offset = 0; // Offset from the start of the buffer, usable as a dynamic descriptor offset
+};
+
+// A persistently mapped buffer split into one partition per frame in flight.
+// Allocations are bump-allocated from the current frame's partition, which is
+// rewound in BeginFrame once the GPU has finished with that frame.
+class VulkanRingBuffer {
+    VK_NON_COPIABLE(VulkanRingBuffer)
+
+public:
+    VulkanRingBuffer(std::shared_ptr<VulkanDevice> device_, std::shared_ptr<VulkanInstance> instance_,
+                     VkDeviceSize frameSize_, uint32_t frameCount_, VkBufferUsageFlags usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+
+    void BeginFrame(uint32_t frameIndex);
+
+    VulkanRingAllocation Allocate(VkDeviceSize size);
+
+    // Publishes this frame's writes to the device, a no-op on host coherent memory
+    void Flush();
+
+    template<class T>
+    uint32_t Push(const T &value) {
+        VulkanRingAllocation allocation = Allocate(sizeof(T));
+        memcpy(allocation.data, &value, sizeof(T));
+        return allocation.offset;
+    }
+
+    std::shared_ptr<VulkanBuffer> GetBuffer();
+
+    VkDeviceSize GetAlignment() const;
+
+    VkDeviceSize GetFrameSize() const;
+
+private:
+    std::shared_ptr<VulkanDevice> device;
+    std::shared_ptr<VulkanInstance> instance;
+
+private:
+    std::shared_ptr<VulkanBuffer> buffer;
+    uint8_t *mappedData = nullptr;
+
+    VkDeviceSize alignment = 1;
+    VkDeviceSize frameSize;
+    uint32_t frameCount;
+
+    uint32_t currentFrame = 0;
+    VkDeviceSize head = 0;
+};
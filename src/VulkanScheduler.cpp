@@ -0,0 +1,174 @@
+#include "VulkanScheduler.h"
+#include "VulkanCommandBuffer.h"
+
+VulkanScheduler::VulkanScheduler(VkDevice device_, VkQueue graphicsQueue, VkQueue computeQueue, VkQueue transferQueue) : device(device_) {
+    graphicsTimeline = CreateTimeline(graphicsQueue);
+    computeTimeline = CreateTimeline(computeQueue);
+    transferTimeline = CreateTimeline(transferQueue);
+}
+
+VulkanScheduler::~VulkanScheduler() {
+    WaitIdle();
+
+    for (auto &timeline: timelines)
+        VkDestroy(vkDestroySemaphore, device, timeline->semaphore);
+}
+
+VulkanScheduler::Timeline *VulkanScheduler::CreateTimeline(VkQueue queue) {
+    for (auto &timeline: timelines) {
+        if (timeline->queue == queue)
+            return timeline.get();
+    }
+
+    VkSemaphoreTypeCreateInfo typeInfo{};
+    typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    typeInfo.initialValue = 0;
+
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphoreInfo.pNext = &typeInfo;
+
+    auto timeline = std::make_unique<Timeline>();
+    timeline->queue = queue;
+    if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &timeline->semaphore) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create timeline semaphore!");
+    }
+
+    timelines.push_back(std::move(timeline));
+    return timelines.back().get();
+}
+
+VulkanScheduler::Timeline &VulkanScheduler::GetTimeline(QueueFamily queue) {
+    switch (queue) {
+        case QueueFamily::Graphics:
+        case QueueFamily::Present:
+            return *graphicsTimeline;
+        case QueueFamily::Compute:
+            return *computeTimeline;
+        case QueueFamily::Transfer:
+            return *transferTimeline;
+        default:
+            throw std::runtime_error("Queue type not supported");
+    }
+}
+
+VulkanTicket VulkanScheduler::Submit(QueueFamily queue, const VulkanSubmission &submission) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    Timeline &timeline = GetTimeline(queue);
+
+    std::vector<VkCommandBuffer> commandBufferHandles;
+    for (const auto &commandBuffer: submission.commandBuffers)
+        commandBufferHandles.push_back(commandBuffer->Handle());
+
+    // Binary semaphores take a dummy value, timeline values are only read for timeline semaphores
+    std::vector<VkSemaphore> waitSemaphores;
+    std::vector<VkPipelineStageFlags> waitStages;
+    std::vector<uint64_t> waitValues;
+    // Tickets of the same queue are waited on as well, submission order alone gives no execution or memory dependency
+    for (const auto &[ticket, stage]: submission.waitTickets) {
+        if (!ticket.IsValid())
+            continue;
+
+        waitSemaphores.push_back(GetTimeline(ticket.queue).semaphore);
+        waitStages.push_back(stage);
+        waitValues.push_back(ticket.value);
+    }
+    for (const auto &[semaphore, stage]: submission.waitSemaphores) {
+        waitSemaphores.push_back(semaphore);
+        waitStages.push_back(stage);
+        waitValues.push_back(0);
+    }
+
+    uint64_t signalValue = timeline.lastSubmittedValue + 1;
+    std::vector<VkSemaphore> signalSemaphores = {timeline.semaphore};
+    std::vector<uint64_t> signalValues = {signalValue};
+    for (VkSemaphore semaphore: submission.signalSemaphores) {
+        signalSemaphores.push_back(semaphore);
+        signalValues.push_back(0);
+    }
+
+    VkTimelineSemaphoreSubmitInfo timelineInfo{};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineInfo.waitSemaphoreValueCount = static_cast<uint32_t>(waitValues.size());
+    timelineInfo.pWaitSemaphoreValues = waitValues.data();
+    timelineInfo.signalSemaphoreValueCount = static_cast<uint32_t>(signalValues.size());
+    timelineInfo.pSignalSemaphoreValues = signalValues.data();
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pNext = &timelineInfo;
+    submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+    submitInfo.pWaitSemaphores = waitSemaphores.data();
+    submitInfo.pWaitDstStageMask = waitStages.data();
+    submitInfo.commandBufferCount = static_cast<uint32_t>(commandBufferHandles.size());
+    submitInfo.pCommandBuffers = commandBufferHandles.data();
+    submitInfo.signalSemaphoreCount = static_cast<uint32_t>(signalSemaphores.size());
+    submitInfo.pSignalSemaphores = signalSemaphores.data();
+
+    VkResult result = vkQueueSubmit(timeline.queue, 1, &submitInfo, VK_NULL_HANDLE);
+    if (result != VK_SUCCESS) {
+        if (result == VK_ERROR_DEVICE_LOST) {
+            throw std::runtime_error("vkQueueSubmit(): VK_ERROR_DEVICE_LOST");
+        } else {
+            throw std::runtime_error("failed to submit command buffers!");
+        }
+    }
+
+    timeline.lastSubmittedValue = signalValue;
+    return {queue, signalValue};
+}
+
+bool VulkanScheduler::IsComplete(const VulkanTicket &ticket) {
+    if (!ticket.IsValid())
+        return true;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    Timeline &timeline = GetTimeline(ticket.queue);
+    if (timeline.lastCompletedValue >= ticket.value)
+        return true;
+
+    uint64_t value = 0;
+    vkGetSemaphoreCounterValue(device, timeline.semaphore, &value);
+    timeline.lastCompletedValue = value;
+
+    return value >= ticket.value;
+}
+
+void VulkanScheduler::Wait(const VulkanTicket &ticket) {
+    if (IsComplete(ticket))
+        return;
+
+    VkSemaphore semaphore;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        semaphore = GetTimeline(ticket.queue).semaphore;
+    }
+
+    VkSemaphoreWaitInfo waitInfo{};
+    waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+    waitInfo.semaphoreCount = 1;
+    waitInfo.pSemaphores = &semaphore;
+    waitInfo.pValues = &ticket.value;
+
+    if (vkWaitSemaphores(device, &waitInfo, UINT64_MAX) != VK_SUCCESS) {
+        throw std::runtime_error("failed to wait for timeline semaphore!");
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    Timeline &timeline = GetTimeline(ticket.queue);
+    timeline.lastCompletedValue = std::max(timeline.lastCompletedValue, ticket.value);
+}
+
+void VulkanScheduler::WaitIdle() {
+    Wait(GetLastTicket(QueueFamily::Graphics));
+    Wait(GetLastTicket(QueueFamily::Compute));
+    Wait(GetLastTicket(QueueFamily::Transfer));
+}
+
+VulkanTicket VulkanScheduler::GetLastTicket(QueueFamily queue) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return {queue, GetTimeline(queue).lastSubmittedValue};
+}
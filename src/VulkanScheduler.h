@@ -0,0 +1,70 @@
+#pragma once
+
+#include <algorithm>
+#include <mutex>
+#include <utility>
+
+#include "vk_common.h"
+
+// Identifies one submission. Every queue has its own timeline semaphore and the value increases
+// with every submit, so a ticket is complete once the queue's timeline has reached its value.
+struct VulkanTicket {
+    QueueFamily queue = QueueFamily::Graphics;
+    uint64_t value = 0;
+
+    bool IsValid() const { return value != 0; }
+};
+
+struct VulkanSubmission {
+    std::vector<std::shared_ptr<VulkanCommandBuffer>> commandBuffers;
+
+    // GPU side dependencies on earlier submissions, possibly on other queues
+    std::vector<std::pair<VulkanTicket, VkPipelineStageFlags>> waitTickets;
+
+    // Binary semaphores, needed for the swap chain's acquire and present operations
+    std::vector<std::pair<VkSemaphore, VkPipelineStageFlags>> waitSemaphores;
+    std::vector<VkSemaphore> signalSemaphores;
+};
+
+class VulkanScheduler {
+    VK_NON_COPIABLE(VulkanScheduler)
+
+public:
+    VulkanScheduler(VkDevice device_, VkQueue graphicsQueue, VkQueue computeQueue, VkQueue transferQueue);
+
+    ~VulkanScheduler();
+
+    VulkanTicket Submit(QueueFamily queue, const VulkanSubmission &submission);
+
+    bool IsComplete(const VulkanTicket &ticket);
+
+    void Wait(const VulkanTicket &ticket);
+
+    void WaitIdle();
+
+    // The most recent ticket of a queue, waiting on it covers everything submitted to the queue so far
+    VulkanTicket GetLastTicket(QueueFamily queue);
+
+private:
+    struct Timeline {
+        VkQueue queue = VK_NULL_HANDLE;
+        VkSemaphore semaphore = VK_NULL_HANDLE;
+        uint64_t lastSubmittedValue = 0;
+        uint64_t lastCompletedValue = 0;
+    };
+
+    Timeline &GetTimeline(QueueFamily queue);
+
+    Timeline *CreateTimeline(VkQueue queue);
+
+private:
+    VkDevice device;
+
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Timeline>> timelines;
+
+    // Queue families that fall back to the same VkQueue share a timeline, since submissions to it are ordered anyway
+    Timeline *graphicsTimeline = nullptr;
+    Timeline *computeTimeline = nullptr;
+    Timeline *transferTimeline = nullptr;
+};
@@ -2,23 +2,42 @@
 
 #include <ios>
 #include <fstream>
+#include <map>
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
 
 #include "VulkanDevice.h"
 
-VulkanShader::VulkanShader(const char *path, std::shared_ptr<VulkanDevice> device_) : device(device_) {
-    auto code = ReadFile(path);
+VulkanShader::VulkanShader(const char *path, std::shared_ptr<VulkanDevice> device_) : VulkanShader(ReadFile(path), device_) {
+}
 
+VulkanShader::VulkanShader(const std::vector<uint32_t> &code, std::shared_ptr<VulkanDevice> device_)
+    : device(device_), reflection(Reflect(code)), contentHash(HashCode(code)) {
     VkShaderModuleCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    createInfo.codeSize = code.size();
-    createInfo.pCode = reinterpret_cast<const uint32_t *>(code.data());
+    createInfo.codeSize = code.size() * sizeof(uint32_t);
+    createInfo.pCode = code.data();
 
     if (vkCreateShaderModule(device->Handle(), &createInfo, nullptr, &shaderModule) != VK_SUCCESS) {
         throw std::runtime_error("failed to create shader module!");
     }
 }
 
-std::vector<char> VulkanShader::ReadFile(const std::string &filename) {
+VulkanShader::~VulkanShader() {
+    // Pipelines don't reference the module after creation, so it can go right away
+    VkDestroy(vkDestroyShaderModule, device->Handle(), shaderModule);
+}
+
+const VulkanShaderReflection &VulkanShader::GetReflection() const {
+    return reflection;
+}
+
+uint64_t VulkanShader::GetContentHash() const {
+    return contentHash;
+}
+
+std::vector<uint32_t> VulkanShader::ReadFile(const std::string &filename) {
     std::ifstream file(filename, std::ios::ate | std::ios::binary);
 
     if (!file.is_open()) {
@@ -26,12 +45,446 @@ std::vector<char> VulkanShader::ReadFile(const std::string &filename) {
     }
 
     size_t fileSize = (size_t) file.tellg();
-    std::vector<char> buffer(fileSize);
+    if (fileSize == 0 || fileSize % sizeof(uint32_t) != 0) {
+        throw std::runtime_error("shader file is not a valid SPIR-V binary!");
+    }
+
+    std::vector<uint32_t> buffer(fileSize / sizeof(uint32_t));
 
     file.seekg(0);
-    file.read(buffer.data(), fileSize);
+    file.read(reinterpret_cast<char *>(buffer.data()), fileSize);
 
     file.close();
 
     return buffer;
 }
+
+uint64_t VulkanShader::HashCode(const std::vector<uint32_t> &code) {
+    // FNV-1a over the words
+    uint64_t hash = 14695981039346656037ull;
+    for (uint32_t word: code) {
+        hash ^= word;
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
+
+std::vector<VulkanShaderBinding> VulkanShader::MergeBindings(const std::vector<std::shared_ptr<VulkanShader>> &shaders) {
+    std::map<std::pair<uint32_t, uint32_t>, VulkanShaderBinding> merged;
+    for (const auto &shader: shaders) {
+        for (const auto &binding: shader->GetReflection().bindings) {
+            auto key = std::make_pair(binding.set, binding.binding);
+            auto existing = merged.find(key);
+            if (existing == merged.end()) {
+                merged.emplace(key, binding);
+                continue;
+            }
+
+            if (existing->second.type != binding.type || existing->second.count != binding.count) {
+                throw std::runtime_error("shader stages disagree on the type of descriptor binding " + binding.name + "!");
+            }
+            existing->second.stages |= binding.stages;
+        }
+    }
+
+    std::vector<VulkanShaderBinding> bindings;
+    for (auto &[key, binding]: merged)
+        bindings.push_back(binding);
+
+    return bindings;
+}
+
+std::vector<VkPushConstantRange> VulkanShader::MergePushConstantRanges(const std::vector<std::shared_ptr<VulkanShader>> &shaders) {
+    // Every stage gets its own range, identical ranges are merged into one with both stages
+    std::vector<VkPushConstantRange> ranges;
+    for (const auto &shader: shaders) {
+        for (const auto &range: shader->GetReflection().pushConstantRanges) {
+            auto existing = std::find_if(ranges.begin(), ranges.end(), [&](const VkPushConstantRange &other) {
+                return other.offset == range.offset && other.size == range.size;
+            });
+
+            if (existing != ranges.end())
+                existing->stageFlags |= range.stageFlags;
+            else
+                ranges.push_back(range);
+        }
+    }
+
+    return ranges;
+}
+
+// Only the subset of SPIR-V needed to describe the resource interface is parsed, everything else is skipped
+namespace {
+    constexpr uint32_t SpirvMagic = 0x07230203;
+
+    enum SpirvOp : uint32_t {
+        OpName = 5,
+        OpEntryPoint = 15,
+        OpTypeInt = 21,
+        OpTypeFloat = 22,
+        OpTypeVector = 23,
+        OpTypeMatrix = 24,
+        OpTypeImage = 25,
+        OpTypeSampler = 26,
+        OpTypeSampledImage = 27,
+        OpTypeArray = 28,
+        OpTypeRuntimeArray = 29,
+        OpTypeStruct = 30,
+        OpTypePointer = 32,
+        OpConstant = 43,
+        OpSpecConstant = 50,
+        OpVariable = 59,
+        OpDecorate = 71,
+        OpMemberDecorate = 72,
+    };
+
+    enum SpirvDecoration : uint32_t {
+        DecorationSpecId = 1,
+        DecorationBlock = 2,
+        DecorationBufferBlock = 3,
+        DecorationArrayStride = 6,
+        DecorationMatrixStride = 7,
+        DecorationBuiltIn = 11,
+        DecorationLocation = 30,
+        DecorationBinding = 33,
+        DecorationDescriptorSet = 34,
+        DecorationOffset = 35,
+    };
+
+    enum SpirvStorageClass : uint32_t {
+        StorageClassUniformConstant = 0,
+        StorageClassInput = 1,
+        StorageClassUniform = 2,
+        StorageClassPushConstant = 9,
+        StorageClassStorageBuffer = 12,
+    };
+
+    enum SpirvDim : uint32_t {
+        DimBuffer = 5,
+        DimSubpassData = 6,
+    };
+
+    struct SpirvType {
+        uint32_t opcode = 0;
+        std::vector<uint32_t> operands; // Everything after the result id
+    };
+
+    struct SpirvDecorations {
+        std::unordered_map<uint32_t, uint32_t> values;
+        std::unordered_map<uint32_t, uint32_t> memberOffsets;
+        std::unordered_map<uint32_t, uint32_t> memberMatrixStrides;
+
+        bool Has(uint32_t decoration) const {
+            return values.count(decoration) != 0;
+        }
+
+        uint32_t Get(uint32_t decoration, uint32_t fallback = 0) const {
+            auto value = values.find(decoration);
+            return value != values.end() ? value->second : fallback;
+        }
+    };
+
+    struct SpirvModule {
+        std::unordered_map<uint32_t, SpirvType> types;
+        std::unordered_map<uint32_t, uint32_t> constants; // Specialization constants hold their default value
+        std::unordered_map<uint32_t, SpirvDecorations> decorations;
+        std::unordered_map<uint32_t, std::string> names;
+
+        const SpirvType &Type(uint32_t id) const {
+            auto type = types.find(id);
+            if (type == types.end()) {
+                throw std::runtime_error("SPIR-V references an unknown type!");
+            }
+            return type->second;
+        }
+
+        uint32_t Constant(uint32_t id) const {
+            auto constant = constants.find(id);
+            if (constant == constants.end()) {
+                throw std::runtime_error("SPIR-V array length is neither a constant nor a specialization constant!");
+            }
+            return constant->second;
+        }
+
+        // Smallest member offset of a struct, push constant blocks don't have to start at 0
+        uint32_t Offset(uint32_t structTypeId) const {
+            const auto &type = Type(structTypeId);
+            auto structDecorations = decorations.find(structTypeId);
+            if (type.opcode != OpTypeStruct || type.operands.empty() || structDecorations == decorations.end())
+                return 0;
+
+            uint32_t offset = UINT32_MAX;
+            for (uint32_t member = 0; member < type.operands.size(); member++) {
+                auto memberOffset = structDecorations->second.memberOffsets.find(member);
+                offset = std::min(offset, memberOffset != structDecorations->second.memberOffsets.end() ? memberOffset->second : 0);
+            }
+            return offset;
+        }
+
+        std::string Name(uint32_t id) const {
+            auto name = names.find(id);
+            return name != names.end() ? name->second : std::string();
+        }
+
+        uint32_t Size(uint32_t typeId, uint32_t matrixStride = 0) const {
+            const auto &type = Type(typeId);
+            switch (type.opcode) {
+                case OpTypeInt:
+                case OpTypeFloat:
+                    return type.operands[0] / 8;
+                case OpTypeVector:
+                    return Size(type.operands[0]) * type.operands[1];
+                case OpTypeMatrix:
+                    return (matrixStride != 0 ? matrixStride : Size(type.operands[0])) * type.operands[1];
+                case OpTypeArray: {
+                    uint32_t stride = decorations.count(typeId) ? decorations.at(typeId).Get(DecorationArrayStride) : 0;
+                    if (stride == 0)
+                        stride = Size(type.operands[0]);
+                    return stride * Constant(type.operands[1]);
+                }
+                case OpTypeStruct: {
+                    uint32_t size = 0;
+                    const SpirvDecorations *structDecorations = decorations.count(typeId) ? &decorations.at(typeId) : nullptr;
+                    for (uint32_t member = 0; member < type.operands.size(); member++) {
+                        uint32_t offset = 0;
+                        uint32_t memberMatrixStride = 0;
+                        if (structDecorations != nullptr) {
+                            auto memberOffset = structDecorations->memberOffsets.find(member);
+                            if (memberOffset != structDecorations->memberOffsets.end())
+                                offset = memberOffset->second;
+                            auto stride = structDecorations->memberMatrixStrides.find(member);
+                            if (stride != structDecorations->memberMatrixStrides.end())
+                                memberMatrixStride = stride->second;
+                        }
+                        size = std::max(size, offset + Size(type.operands[member], memberMatrixStride));
+                    }
+                    return size;
+                }
+                default:
+                    // Runtime arrays and opaque types have no static size
+                    return 0;
+            }
+        }
+    };
+
+    std::string ReadString(const uint32_t *words, uint32_t wordCount) {
+        const char *characters = reinterpret_cast<const char *>(words);
+        return {characters, strnlen(characters, wordCount * sizeof(uint32_t))};
+    }
+
+    VkShaderStageFlagBits ToShaderStage(uint32_t executionModel) {
+        switch (executionModel) {
+            case 0: return VK_SHADER_STAGE_VERTEX_BIT;
+            case 1: return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+            case 2: return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+            case 3: return VK_SHADER_STAGE_GEOMETRY_BIT;
+            case 4: return VK_SHADER_STAGE_FRAGMENT_BIT;
+            case 5: return VK_SHADER_STAGE_COMPUTE_BIT;
+            default: throw std::runtime_error("unsupported shader execution model!");
+        }
+    }
+
+    VkFormat ToVertexFormat(const SpirvModule &module, uint32_t typeId) {
+        const auto *type = &module.Type(typeId);
+        uint32_t componentCount = 1;
+        if (type->opcode == OpTypeVector) {
+            componentCount = type->operands[1];
+            type = &module.Type(type->operands[0]);
+        }
+
+        if (type->opcode == OpTypeFloat && type->operands[0] == 32) {
+            const VkFormat formats[] = {VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT};
+            return formats[componentCount - 1];
+        }
+        if (type->opcode == OpTypeInt && type->operands[0] == 32 && type->operands[1] == 1) {
+            const VkFormat formats[] = {VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT};
+            return formats[componentCount - 1];
+        }
+        if (type->opcode == OpTypeInt && type->operands[0] == 32) {
+            const VkFormat formats[] = {VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT};
+            return formats[componentCount - 1];
+        }
+
+        // Matrices and 64 bit inputs span several locations and have no single format
+        return VK_FORMAT_UNDEFINED;
+    }
+
+    VkDescriptorType ToDescriptorType(const SpirvModule &module, uint32_t storageClass, uint32_t typeId) {
+        const auto &type = module.Type(typeId);
+
+        if (storageClass == StorageClassStorageBuffer)
+            return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        if (storageClass == StorageClassUniform) {
+            bool isBufferBlock = module.decorations.count(typeId) && module.decorations.at(typeId).Has(DecorationBufferBlock);
+            return isBufferBlock ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        }
+
+        switch (type.opcode) {
+            case OpTypeSampler:
+                return VK_DESCRIPTOR_TYPE_SAMPLER;
+            case OpTypeSampledImage:
+                return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            case OpTypeImage: {
+                uint32_t dim = type.operands[1];
+                uint32_t sampled = type.operands[5];
+                if (dim == DimSubpassData)
+                    return VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+                if (dim == DimBuffer)
+                    return sampled == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+                return sampled == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+            }
+            default:
+                throw std::runtime_error("unsupported descriptor type in shader!");
+        }
+    }
+}
+
+VulkanShaderReflection VulkanShader::Reflect(const std::vector<uint32_t> &code) {
+    if (code.size() < 5 || code[0] != SpirvMagic) {
+        throw std::runtime_error("shader code is not a valid SPIR-V binary!");
+    }
+
+    SpirvModule module;
+    VulkanShaderReflection result;
+    bool hasEntryPoint = false;
+
+    struct Variable {
+        uint32_t id;
+        uint32_t pointerTypeId;
+        uint32_t storageClass;
+    };
+    std::vector<Variable> variables;
+
+    for (size_t offset = 5; offset < code.size();) {
+        uint32_t opcode = code[offset] & 0xffff;
+        uint32_t wordCount = code[offset] >> 16;
+        if (wordCount == 0 || offset + wordCount > code.size()) {
+            throw std::runtime_error("SPIR-V binary is truncated!");
+        }
+        const uint32_t *operands = &code[offset + 1];
+        uint32_t operandCount = wordCount - 1;
+
+        switch (opcode) {
+            case OpName:
+                module.names[operands[0]] = ReadString(operands + 1, operandCount - 1);
+                break;
+            case OpEntryPoint:
+                // Modules with several entry points are reflected as the first one
+                if (!hasEntryPoint) {
+                    result.stage = ToShaderStage(operands[0]);
+                    hasEntryPoint = true;
+                }
+                break;
+            case OpTypeInt:
+            case OpTypeFloat:
+            case OpTypeVector:
+            case OpTypeMatrix:
+            case OpTypeImage:
+            case OpTypeSampler:
+            case OpTypeSampledImage:
+            case OpTypeArray:
+            case OpTypeRuntimeArray:
+            case OpTypeStruct:
+            case OpTypePointer:
+                module.types[operands[0]] = {opcode, std::vector<uint32_t>(operands + 1, operands + operandCount)};
+                break;
+            case OpConstant:
+            case OpSpecConstant:
+                module.constants[operands[1]] = operands[2];
+                break;
+            case OpVariable:
+                variables.push_back({operands[1], operands[0], operands[2]});
+                break;
+            case OpDecorate:
+                module.decorations[operands[0]].values[operands[1]] = operandCount > 2 ? operands[2] : 0;
+                break;
+            case OpMemberDecorate:
+                if (operands[2] == DecorationOffset)
+                    module.decorations[operands[0]].memberOffsets[operands[1]] = operands[3];
+                else if (operands[2] == DecorationMatrixStride)
+                    module.decorations[operands[0]].memberMatrixStrides[operands[1]] = operands[3];
+                break;
+            default:
+                break;
+        }
+
+        offset += wordCount;
+    }
+
+    if (!hasEntryPoint) {
+        throw std::runtime_error("SPIR-V binary has no entry point!");
+    }
+
+    for (const auto &variable: variables) {
+        const auto &pointerType = module.Type(variable.pointerTypeId);
+        uint32_t typeId = pointerType.operands[1];
+        SpirvDecorations noDecorations;
+        const auto &decorations = module.decorations.count(variable.id) ? module.decorations.at(variable.id) : noDecorations;
+
+        switch (variable.storageClass) {
+            case StorageClassUniformConstant:
+            case StorageClassUniform:
+            case StorageClassStorageBuffer: {
+                VulkanShaderBinding binding{};
+                binding.set = decorations.Get(DecorationDescriptorSet);
+                binding.binding = decorations.Get(DecorationBinding);
+                binding.stages = result.stage;
+                binding.name = module.Name(variable.id);
+
+                // Arrays of resources become the descriptor count
+                const auto &type = module.Type(typeId);
+                if (type.opcode == OpTypeArray) {
+                    // Arrays sized by a specialization constant are reflected with its default value
+                    binding.count = module.Constant(type.operands[1]);
+                    typeId = type.operands[0];
+                } else if (type.opcode == OpTypeRuntimeArray) {
+                    binding.count = 0;
+                    typeId = type.operands[0];
+                }
+
+                if (binding.name.empty())
+                    binding.name = module.Name(typeId);
+                binding.type = ToDescriptorType(module, variable.storageClass, typeId);
+                result.bindings.push_back(binding);
+                break;
+            }
+            case StorageClassPushConstant: {
+                VkPushConstantRange range{};
+                range.stageFlags = result.stage;
+                range.offset = module.Offset(typeId);
+                range.size = module.Size(typeId) - range.offset;
+                result.pushConstantRanges.push_back(range);
+                break;
+            }
+            case StorageClassInput: {
+                if (result.stage != VK_SHADER_STAGE_VERTEX_BIT || decorations.Has(DecorationBuiltIn) || !decorations.Has(DecorationLocation))
+                    break;
+
+                VulkanShaderVertexInput input{};
+                input.location = decorations.Get(DecorationLocation);
+                input.format = ToVertexFormat(module, typeId);
+                input.name = module.Name(variable.id);
+                result.vertexInputs.push_back(input);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    for (const auto &[id, decorations]: module.decorations) {
+        if (decorations.Has(DecorationSpecId))
+            result.specializationConstantIds.push_back(decorations.Get(DecorationSpecId));
+    }
+    std::sort(result.specializationConstantIds.begin(), result.specializationConstantIds.end());
+
+    std::sort(result.bindings.begin(), result.bindings.end(), [](const VulkanShaderBinding &a, const VulkanShaderBinding &b) {
+        return std::make_pair(a.set, a.binding) < std::make_pair(b.set, b.binding);
+    });
+    std::sort(result.vertexInputs.begin(), result.vertexInputs.end(), [](const VulkanShaderVertexInput &a, const VulkanShaderVertexInput &b) {
+        return a.location < b.location;
+    });
+
+    return result;
+}
@@ -1,18 +1,65 @@
 #pragma once
 
+#include <string>
+
 #include "vk_common.h"
 
+// A descriptor binding the shader declares. The descriptor count is 0 for runtime sized arrays.
+struct VulkanShaderBinding {
+    uint32_t set = 0;
+    uint32_t binding = 0;
+    VkDescriptorType type = VK_DESCRIPTOR_TYPE_MAX_ENUM;
+    uint32_t count = 1;
+    VkShaderStageFlags stages = 0;
+    std::string name;
+};
+
+struct VulkanShaderVertexInput {
+    uint32_t location = 0;
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    std::string name;
+};
+
+// Interface of a shader module as declared in its SPIR-V
+struct VulkanShaderReflection {
+    VkShaderStageFlagBits stage = VK_SHADER_STAGE_ALL;
+    std::vector<VulkanShaderBinding> bindings;
+    std::vector<VkPushConstantRange> pushConstantRanges;
+    std::vector<VulkanShaderVertexInput> vertexInputs; // Only filled for vertex shaders
+    std::vector<uint32_t> specializationConstantIds;
+};
+
 class VulkanShader {
     VK_NON_COPIABLE(VulkanShader)
 
 public:
     VulkanShader(const char* path, std::shared_ptr<VulkanDevice> device_);
 
+    VulkanShader(const std::vector<uint32_t> &code, std::shared_ptr<VulkanDevice> device_);
+
+    ~VulkanShader();
+
+    const VulkanShaderReflection &GetReflection() const;
+
+    uint64_t GetContentHash() const;
+
+public:
+    static std::vector<uint32_t> ReadFile(const std::string &filename);
+
+    static uint64_t HashCode(const std::vector<uint32_t> &code);
+
+    // Bindings of all shaders of a pipeline, a binding used by several stages is listed once with the union of the stages
+    static std::vector<VulkanShaderBinding> MergeBindings(const std::vector<std::shared_ptr<VulkanShader>> &shaders);
+
+    static std::vector<VkPushConstantRange> MergePushConstantRanges(const std::vector<std::shared_ptr<VulkanShader>> &shaders);
+
 private:
-    static std::vector<char> ReadFile(const std::string &filename);
+    static VulkanShaderReflection Reflect(const std::vector<uint32_t> &code);
 
 private:
     std::shared_ptr<VulkanDevice> device;
+    VulkanShaderReflection reflection;
+    uint64_t contentHash = 0;
 
 VK_HANDLE(VkShaderModule, shaderModule);
 };
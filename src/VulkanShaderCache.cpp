@@ -0,0 +1,38 @@
+#include "VulkanShaderCache.h"
+#include "VulkanShader.h"
+
+VulkanShaderCache::VulkanShaderCache(std::shared_ptr<VulkanDevice> device_) : device(device_) {
+}
+
+std::shared_ptr<VulkanShader> VulkanShaderCache::Load(const std::string &path) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto loaded = shadersByPath.find(path);
+    if (loaded != shadersByPath.end())
+        return loaded->second;
+
+    auto code = VulkanShader::ReadFile(path);
+    uint64_t contentHash = VulkanShader::HashCode(code);
+
+    std::shared_ptr<VulkanShader> shader;
+    auto [begin, end] = shadersByContent.equal_range(contentHash);
+    for (auto cached = begin; cached != end; ++cached) {
+        if (cached->second.code == code) {
+            shader = cached->second.shader;
+            break;
+        }
+    }
+
+    if (shader == nullptr) {
+        shader = std::make_shared<VulkanShader>(code, device);
+        shadersByContent.emplace(contentHash, CachedModule{code, shader});
+    }
+    shadersByPath[path] = shader;
+
+    return shader;
+}
+
+size_t VulkanShaderCache::GetModuleCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return shadersByContent.size();
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "vk_common.h"
+
+// Loads every SPIR-V file once and keeps the modules alive for the lifetime of the cache.
+// Files with identical contents share one module. Safe to use from the pipeline compilation workers.
+class VulkanShaderCache {
+    VK_NON_COPIABLE(VulkanShaderCache)
+
+public:
+    explicit VulkanShaderCache(std::shared_ptr<VulkanDevice> device_);
+
+    std::shared_ptr<VulkanShader> Load(const std::string &path);
+
+    size_t GetModuleCount();
+
+private:
+    // The code is kept to compare it on hash matches, a collision must not hand out another file's module
+    struct CachedModule {
+        std::vector<uint32_t> code;
+        std::shared_ptr<VulkanShader> shader;
+    };
+
+    std::shared_ptr<VulkanDevice> device;
+
+    std::mutex mutex;
+    std::unordered_map<std::string, std::shared_ptr<VulkanShader>> shadersByPath;
+    std::unordered_multimap<uint64_t, CachedModule> shadersByContent;
+};
@@ -8,16 +8,27 @@
 #include "VulkanImage.h"
 #include "VulkanImageView.h"
 #include "VulkanCommandBuffer.h"
+#include "VulkanScheduler.h"
+#include "VulkanDeletionQueue.h"
+
+VulkanSwapChain::VulkanSwapChain(std::shared_ptr<VulkanWindow> window_, std::shared_ptr<VulkanDevice> device_, std::shared_ptr<VulkanInstance> instance_,
+                                 std::shared_ptr<VulkanSwapChain> oldSwapChain, const VulkanSwapChainConfig &config_)
+    : config(config_), device(device_), instance(instance_), window(window_) {
+    if (config.maxFramesInFlight < 1) {
+        throw std::invalid_argument("a swap chain needs at least one frame in flight!");
+    }
+    maxFramesInFlight = config.maxFramesInFlight;
 
-VulkanSwapChain::VulkanSwapChain(std::shared_ptr<VulkanWindow> window_, std::shared_ptr<VulkanDevice> device_, std::shared_ptr<VulkanInstance> instance_)
-    : window(window_), device(device_), instance(instance_) {
     SwapChainSupportDetails swapChainSupport = instance->QuerySwapChainSupport();
 
     VkSurfaceFormatKHR surfaceFormat = ChooseSwapSurfaceFormat(swapChainSupport.formats);
-    VkPresentModeKHR presentMode = ChooseSwapPresentMode(swapChainSupport.presentModes);
+    presentMode = ChooseSwapPresentMode(swapChainSupport.presentModes);
     VkExtent2D extent = ChooseSwapExtent(swapChainSupport.capabilities);
 
-    swapImageCount = std::max(swapChainSupport.capabilities.minImageCount, std::min(desiredSwapImageCount, swapChainSupport.capabilities.maxImageCount));
+    // A maximum image count of 0 means there is no limit
+    swapImageCount = std::max(swapChainSupport.capabilities.minImageCount, config.imageCount);
+    if (swapChainSupport.capabilities.maxImageCount > 0)
+        swapImageCount = std::min(swapImageCount, swapChainSupport.capabilities.maxImageCount);
 
     VkSwapchainCreateInfoKHR createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
@@ -45,6 +56,7 @@ VulkanSwapChain::VulkanSwapChain(std::shared_ptr<VulkanWindow> window_, std::sha
     createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
     createInfo.presentMode = presentMode;
     createInfo.clipped = VK_TRUE;
+    createInfo.oldSwapchain = oldSwapChain != nullptr ? oldSwapChain->Handle() : VK_NULL_HANDLE;
 
     if (vkCreateSwapchainKHR(device->Handle(), &createInfo, nullptr, &swapChain) != VK_SUCCESS) {
         throw std::runtime_error("failed to create swap chain!");
@@ -63,20 +75,23 @@ VulkanSwapChain::VulkanSwapChain(std::shared_ptr<VulkanWindow> window_, std::sha
     // Create Synchronization objects
     imageAvailableSemaphores.resize(maxFramesInFlight);
     renderFinishedSemaphores.resize(maxFramesInFlight);
-    inFlightFences.resize(maxFramesInFlight);
+    inFlightTickets.resize(maxFramesInFlight);
+    if (oldSwapChain != nullptr) {
+        // Per-frame resources outside the swap chain are sized for the old frame count, so it can't change on recreation
+        if (oldSwapChain->maxFramesInFlight != maxFramesInFlight) {
+            throw std::invalid_argument("the number of frames in flight can't change when the swap chain is recreated!");
+        }
+        inFlightTickets = oldSwapChain->inFlightTickets;
+        currentFrame = oldSwapChain->currentFrame;
+    }
     imagesInFlight.resize(swapImageCount);
 
     VkSemaphoreCreateInfo semaphoreInfo{};
     semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-    VkFenceCreateInfo fenceInfo{};
-    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-
-    for (size_t i = 0; i < maxFramesInFlight; i++) {
+    for (int i = 0; i < maxFramesInFlight; i++) {
         if (vkCreateSemaphore(device->Handle(), &semaphoreInfo, nullptr, &imageAvailableSemaphores[i]) != VK_SUCCESS ||
-            vkCreateSemaphore(device->Handle(), &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]) != VK_SUCCESS ||
-            vkCreateFence(device->Handle(), &fenceInfo, nullptr, &inFlightFences[i]) != VK_SUCCESS) {
+            vkCreateSemaphore(device->Handle(), &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]) != VK_SUCCESS) {
             throw std::runtime_error("failed to create synchronization objects for a frame!");
         }
     }
@@ -93,11 +108,13 @@ VkSurfaceFormatKHR VulkanSwapChain::ChooseSwapSurfaceFormat(const std::vector<Vk
 }
 
 VkPresentModeKHR VulkanSwapChain::ChooseSwapPresentMode(const std::vector<VkPresentModeKHR> &availablePresentModes) {
-    // VSync ON = VK_PRESENT_MODE_FIFO_KHR
-    // VSync OFF = VK_PRESENT_MODE_MAILBOX_KHR
+    for (auto preferredPresentMode: config.presentModes) {
+        if (std::find(availablePresentModes.begin(), availablePresentModes.end(), preferredPresentMode) != availablePresentModes.end())
+            return preferredPresentMode;
+    }
 
-    return VK_PRESENT_MODE_MAILBOX_KHR;
-    //return VK_PRESENT_MODE_FIFO_KHR;
+    // FIFO is required to be supported
+    return VK_PRESENT_MODE_FIFO_KHR;
 }
 
 VkExtent2D VulkanSwapChain::ChooseSwapExtent(const VkSurfaceCapabilitiesKHR &capabilities) {
@@ -136,7 +153,7 @@ VkFormat VulkanSwapChain::GetFormat() {
 }
 
 void VulkanSwapChain::WaitForLastSubmit() {
-    vkWaitForFences(device->Handle(), 1, &inFlightFences[currentFrame], VK_TRUE, UINT64_MAX);
+    device->GetScheduler()->Wait(inFlightTickets[currentFrame]);
 }
 
 uint32_t VulkanSwapChain::AcquireNextImage() {
@@ -149,34 +166,19 @@ uint32_t VulkanSwapChain::AcquireNextImage() {
     return imageIndex;
 }
 
-void VulkanSwapChain::SubmitCommands(std::shared_ptr<VulkanCommandBuffer> commandBuffer) {
-    if (imagesInFlight[imageIndex] != VK_NULL_HANDLE) {
-        vkWaitForFences(device->Handle(), 1, &imagesInFlight[imageIndex], VK_TRUE, UINT64_MAX);
-    }
-    imagesInFlight[imageIndex] = inFlightFences[currentFrame];
-
-    auto commandBufferHandle = commandBuffer->Handle();
-    VkSubmitInfo submitInfo{};
-    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-    submitInfo.waitSemaphoreCount = 1;
-    submitInfo.pWaitSemaphores = &imageAvailableSemaphores[currentFrame]; // Wait for vkAcquireNextImageKHR to signal the semaphore
-    submitInfo.pWaitDstStageMask = waitStages;
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &commandBufferHandle;
-    submitInfo.signalSemaphoreCount = 1;
-    submitInfo.pSignalSemaphores = &renderFinishedSemaphores[currentFrame]; // Signal this semaphore when rendering is finished
-
-    vkResetFences(device->Handle(), 1, &inFlightFences[currentFrame]); // Reset this fence before giving it to vkQueueSubmit
-
-    lastSubmitResult = vkQueueSubmit(device->GetGraphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]); // Signal this CPU fence after all the commands have executed
-    if (lastSubmitResult != VK_SUCCESS) {
-        if (lastSubmitResult == VK_ERROR_DEVICE_LOST) {
-            throw std::runtime_error("vkQueueSubmit(): VK_ERROR_DEVICE_LOST");
-        } else {
-            throw std::runtime_error("failed to submit draw command buffer!");
-        }
-    }
+VulkanTicket VulkanSwapChain::SubmitCommands(std::shared_ptr<VulkanCommandBuffer> commandBuffer) {
+    device->GetScheduler()->Wait(imagesInFlight[imageIndex]);
+
+    VulkanSubmission submission{};
+    submission.commandBuffers = {commandBuffer};
+    submission.waitSemaphores = {{imageAvailableSemaphores[currentFrame], VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT}}; // Wait for vkAcquireNextImageKHR to signal the semaphore
+    submission.signalSemaphores = {renderFinishedSemaphores[currentFrame]}; // Signal this semaphore when rendering is finished
+
+    VulkanTicket ticket = device->GetScheduler()->Submit(QueueFamily::Graphics, submission);
+    inFlightTickets[currentFrame] = ticket;
+    imagesInFlight[imageIndex] = ticket;
+
+    return ticket;
 }
 
 void VulkanSwapChain::Present() {
@@ -211,6 +213,51 @@ uint32_t VulkanSwapChain::GetCurrentImage() const {
     return currentFrame;
 }
 
-VulkanSwapChain::~VulkanSwapChain() {
+uint32_t VulkanSwapChain::GetCurrentFrame() const {
+    return currentFrame;
+}
+
+int VulkanSwapChain::GetMaxFramesInFlight() const {
+    return maxFramesInFlight;
+}
+
+VkPresentModeKHR VulkanSwapChain::GetPresentMode() const {
+    return presentMode;
+}
+
+const VulkanSwapChainConfig &VulkanSwapChain::GetConfig() const {
+    return config;
+}
+
+VulkanSwapChainConfig VulkanSwapChainConfig::LowLatency() {
+    VulkanSwapChainConfig config;
+    config.presentModes = {VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_FIFO_RELAXED_KHR, VK_PRESENT_MODE_FIFO_KHR};
+    config.imageCount = 3;
+    config.maxFramesInFlight = 1;
+    return config;
+}
 
+VulkanSwapChainConfig VulkanSwapChainConfig::Throughput() {
+    VulkanSwapChainConfig config;
+    config.presentModes = {VK_PRESENT_MODE_FIFO_KHR};
+    config.imageCount = 3;
+    config.maxFramesInFlight = 3;
+    return config;
+}
+
+VulkanSwapChain::~VulkanSwapChain() {
+    imageViews.clear();
+    images.clear();
+
+    // The swap chain images are destroyed together with the swap chain
+    VkDevice deviceHandle = device->Handle();
+    device->GetDeletionQueue()->Enqueue([deviceHandle, swapChain = swapChain,
+                                         imageAvailableSemaphores = imageAvailableSemaphores,
+                                         renderFinishedSemaphores = renderFinishedSemaphores]() mutable {
+        for (auto &semaphore: imageAvailableSemaphores)
+            VkDestroy(vkDestroySemaphore, deviceHandle, semaphore);
+        for (auto &semaphore: renderFinishedSemaphores)
+            VkDestroy(vkDestroySemaphore, deviceHandle, semaphore);
+        VkDestroy(vkDestroySwapchainKHR, deviceHandle, swapChain);
+    });
 }
@@ -1,12 +1,30 @@
 #pragma once
 
 #include "vk_common.h"
+#include "VulkanScheduler.h"
+
+// Creation parameters of a swap chain. The present modes are tried in order, FIFO is the final fallback
+// since it is the only mode every implementation supports. The image count is clamped to the surface limits.
+struct VulkanSwapChainConfig {
+    std::vector<VkPresentModeKHR> presentModes = {VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_FIFO_KHR};
+    uint32_t imageCount = 3;
+    int maxFramesInFlight = 2;
+
+    // Shortest input to display time, may tear when mailbox is not available
+    static VulkanSwapChainConfig LowLatency();
+
+    // No tearing and the CPU can run further ahead of the GPU, at the cost of latency
+    static VulkanSwapChainConfig Throughput();
+};
 
 class VulkanSwapChain {
     VK_NON_COPIABLE(VulkanSwapChain)
 
 public:
-    VulkanSwapChain(std::shared_ptr<VulkanWindow> window_, std::shared_ptr<VulkanDevice> device_, std::shared_ptr<VulkanInstance> instance_);
+    // Passing the previous swap chain lets the driver reuse its resources and keeps the frame pacing,
+    // the old one can be released right after without waiting for the device to go idle
+    VulkanSwapChain(std::shared_ptr<VulkanWindow> window_, std::shared_ptr<VulkanDevice> device_, std::shared_ptr<VulkanInstance> instance_,
+                    std::shared_ptr<VulkanSwapChain> oldSwapChain = nullptr, const VulkanSwapChainConfig &config_ = VulkanSwapChainConfig());
 
     ~VulkanSwapChain();
 
@@ -14,7 +32,7 @@ public:
 
     uint32_t AcquireNextImage();
 
-    void SubmitCommands(std::shared_ptr<VulkanCommandBuffer> commandBuffer);
+    VulkanTicket SubmitCommands(std::shared_ptr<VulkanCommandBuffer> commandBuffer);
 
     void Present();
 
@@ -30,6 +48,14 @@ public:
 
     uint32_t GetCurrentImage() const;
 
+    uint32_t GetCurrentFrame() const;
+
+    int GetMaxFramesInFlight() const;
+
+    VkPresentModeKHR GetPresentMode() const;
+
+    const VulkanSwapChainConfig &GetConfig() const;
+
 private:
     VkSurfaceFormatKHR ChooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR> &availableFormats);
 
@@ -38,9 +64,10 @@ private:
     VkExtent2D ChooseSwapExtent(const VkSurfaceCapabilitiesKHR &capabilities);
 
 private:
-    const int maxFramesInFlight = 2;
-    const uint32_t desiredSwapImageCount = 3;
+    VulkanSwapChainConfig config;
+    int maxFramesInFlight = 2;
     uint32_t swapImageCount = -1;
+    VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;
 
     std::shared_ptr<VulkanDevice> device;
     std::shared_ptr<VulkanInstance> instance;
@@ -51,8 +78,8 @@ private:
 
     std::vector<VkSemaphore> imageAvailableSemaphores;
     std::vector<VkSemaphore> renderFinishedSemaphores;
-    std::vector<VkFence> inFlightFences;
-    std::vector<VkFence> imagesInFlight;
+    std::vector<VulkanTicket> inFlightTickets;
+    std::vector<VulkanTicket> imagesInFlight;
 
     uint32_t imageIndex = 0;
     uint32_t currentFrame = 0;
@@ -60,7 +87,6 @@ private:
     VkExtent2D swapChainExtent;
 
     VkResult lastAcquireResult = VK_SUCCESS;
-    VkResult lastSubmitResult = VK_SUCCESS;
     VkResult lastPresentResult = VK_SUCCESS;
 
 
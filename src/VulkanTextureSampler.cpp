@@ -1,6 +1,7 @@
 #include "VulkanTextureSampler.h"
 #include "VulkanInstance.h"
 #include "VulkanDevice.h"
+#include "VulkanDeletionQueue.h"
 
 VulkanTextureSampler::VulkanTextureSampler(std::shared_ptr<VulkanInstance> instance_, std::shared_ptr<VulkanDevice> device_)
     : instance(instance_), device(device_) {
@@ -32,5 +33,8 @@ VulkanTextureSampler::VulkanTextureSampler(std::shared_ptr<VulkanInstance> insta
 }
 
 VulkanTextureSampler::~VulkanTextureSampler() {
-    vkDestroySampler(device->Handle(), textureSampler, nullptr);
+    VkDevice deviceHandle = device->Handle();
+    device->GetDeletionQueue()->Enqueue([deviceHandle, textureSampler = textureSampler]() mutable {
+        VkDestroy(vkDestroySampler, deviceHandle, textureSampler);
+    });
 }
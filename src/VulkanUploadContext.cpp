@@ -0,0 +1,212 @@
+#include "VulkanUploadContext.h"
+#include "VulkanDevice.h"
+#include "VulkanInstance.h"
+#include "VulkanBuffer.h"
+#include "VulkanImage.h"
+#include "VulkanCommandPool.h"
+#include "VulkanCommandBuffer.h"
+#include "VulkanScheduler.h"
+#include "VulkanBarrierBatcher.h"
+
+static const VkAccessFlags2 UploadConsumerAccess = VK_ACCESS_2_INDEX_READ_BIT | VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_2_UNIFORM_READ_BIT |
+                                                  VK_ACCESS_2_SHADER_READ_BIT;
+static const VkPipelineStageFlags2 UploadConsumerStages = VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT | VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT |
+                                                          VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+
+VulkanUploadContext::VulkanUploadContext(std::shared_ptr<VulkanDevice> device_, std::shared_ptr<VulkanInstance> instance_,
+                                         std::shared_ptr<VulkanCommandPool> commandPool_, std::shared_ptr<VulkanCommandPool> transferCommandPool_,
+                                         VkDeviceSize stagingSize_)
+    : device(device_), instance(instance_), commandPool(commandPool_), transferCommandPool(transferCommandPool_), stagingSize(stagingSize_) {
+    stagingBuffer = std::make_shared<VulkanBuffer>(device, instance, stagingSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                                   VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    commandBuffer = commandPool->AllocateBuffer();
+    barriers = std::make_shared<VulkanBarrierBatcher>(commandBuffer);
+
+    graphicsFamilyIndex = instance->GetQueueFamilyIndex(QueueFamily::Graphics);
+    transferFamilyIndex = instance->GetQueueFamilyIndex(QueueFamily::Transfer);
+
+    // Without a dedicated transfer family there is nothing to overlap with, everything goes to the graphics queue
+    if (transferCommandPool != nullptr && device->HasDedicatedTransferQueue() && transferFamilyIndex != graphicsFamilyIndex) {
+        transferCommandBuffer = transferCommandPool->AllocateBuffer();
+        transferBarriers = std::make_shared<VulkanBarrierBatcher>(transferCommandBuffer);
+    }
+}
+
+VulkanUploadContext::~VulkanUploadContext() {
+    Wait();
+}
+
+void VulkanUploadContext::UploadBuffer(std::shared_ptr<VulkanBuffer> destination, const void *data, VkDeviceSize size, VkDeviceSize destinationOffset) {
+    std::shared_ptr<VulkanBuffer> source;
+    VkDeviceSize sourceOffset;
+    StageData(data, size, source, sourceOffset);
+
+    if (!IsAsync()) {
+        source->CopyTo(commandBuffer, destination, size, sourceOffset, destinationOffset);
+        return;
+    }
+
+    source->CopyTo(transferCommandBuffer, destination, size, sourceOffset, destinationOffset);
+
+    // Release on the transfer queue, then acquire the same range on the graphics queue. Both halves are batched until Submit()
+    transferBarriers->TransferOwnership(*barriers, destination, destinationOffset, size, transferFamilyIndex, graphicsFamilyIndex,
+                                        VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, UploadConsumerStages, UploadConsumerAccess);
+}
+
+void VulkanUploadContext::UploadImage(std::shared_ptr<VulkanImage> destination, const void *data, VkDeviceSize size) {
+    std::shared_ptr<VulkanBuffer> source;
+    VkDeviceSize sourceOffset;
+    StageData(data, size, source, sourceOffset);
+
+    // Recorded at Submit(), so the layout transitions of every image in the batch share their barriers
+    pendingImages.push_back({destination, source, sourceOffset});
+}
+
+std::shared_ptr<VulkanCommandBuffer> VulkanUploadContext::GetCommandBuffer() {
+    BeginRecording();
+    return commandBuffer;
+}
+
+bool VulkanUploadContext::IsAsync() const {
+    return transferCommandBuffer != nullptr;
+}
+
+bool VulkanUploadContext::IsComplete() {
+    return !isPending || device->GetScheduler()->IsComplete(ticket);
+}
+
+VulkanTicket VulkanUploadContext::GetTicket() const {
+    return ticket;
+}
+
+void VulkanUploadContext::BeginRecording() {
+    if (isRecording)
+        return;
+
+    // The previous batch may still be reading from the staging arena
+    Wait();
+
+    commandBuffer->Reset();
+    commandBuffer->Begin(true);
+    if (IsAsync()) {
+        transferCommandBuffer->Reset();
+        transferCommandBuffer->Begin(true);
+    }
+    isRecording = true;
+}
+
+void VulkanUploadContext::Submit() {
+    if (!isRecording)
+        return;
+
+    RecordImageUploads();
+
+    // Make the copied buffer contents visible to every stage that may consume them later
+    barriers->MemoryBarrier(VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, UploadConsumerStages, UploadConsumerAccess);
+    barriers->Flush();
+
+    commandBuffer->End();
+    if (IsAsync())
+        transferCommandBuffer->End();
+    isRecording = false;
+
+    stagingBuffer->Flush();
+    for (auto &buffer: oversizedStagingBuffers)
+        buffer->Flush();
+
+    auto scheduler = device->GetScheduler();
+
+    VulkanSubmission submission{};
+    submission.commandBuffers = {commandBuffer};
+    if (IsAsync()) {
+        VulkanSubmission transferSubmission{};
+        transferSubmission.commandBuffers = {transferCommandBuffer};
+        VulkanTicket transferTicket = scheduler->Submit(QueueFamily::Transfer, transferSubmission);
+
+        // The acquire barriers must not execute before the transfer queue has released the resources,
+        // and their destination stages have to be covered by the wait
+        submission.waitTickets = {{transferTicket, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT}};
+    }
+
+    ticket = scheduler->Submit(QueueFamily::Graphics, submission);
+    isPending = true;
+}
+
+void VulkanUploadContext::Wait() {
+    if (!isPending)
+        return;
+
+    device->GetScheduler()->Wait(ticket);
+    isPending = false;
+
+    stagingHead = 0;
+    oversizedStagingBuffers.clear();
+}
+
+void VulkanUploadContext::Flush() {
+    Submit();
+    Wait();
+}
+
+void VulkanUploadContext::RecordImageUploads() {
+    auto copyCommandBuffer = IsAsync() ? transferCommandBuffer : commandBuffer;
+    auto copyBarriers = IsAsync() ? transferBarriers : barriers;
+
+    // One barrier call moves every image of the batch into TRANSFER_DST before the copies
+    for (auto &upload: pendingImages)
+        copyBarriers->Transition(upload.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT);
+    copyBarriers->Flush();
+
+    for (auto &upload: pendingImages)
+        upload.source->CopyTo(copyCommandBuffer, upload.image, upload.sourceOffset);
+
+    if (IsAsync()) {
+        // The images keep their TRANSFER_DST layout across the queue transfer, mip generation happens on the graphics side
+        for (auto &upload: pendingImages) {
+            transferBarriers->TransferOwnership(*barriers, upload.image, transferFamilyIndex, graphicsFamilyIndex,
+                                                VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_READ_BIT | VK_ACCESS_2_TRANSFER_WRITE_BIT);
+        }
+
+        // Releases and acquires of the buffers are part of these flushes as well
+        transferBarriers->Flush();
+        barriers->Flush();
+    }
+
+    // The final transitions to shader reads stay in the batcher and go out with the closing barrier of the batch
+    for (auto &upload: pendingImages) {
+        if (upload.image->GetMipLevels() > 1)
+            upload.image->GenerateMipMaps(*barriers);
+        else
+            barriers->Transition(upload.image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_READ_BIT);
+    }
+
+    pendingImages.clear();
+}
+
+void VulkanUploadContext::StageData(const void *data, VkDeviceSize size, std::shared_ptr<VulkanBuffer> &source, VkDeviceSize &sourceOffset) {
+    // Starting the recording waits for the previous batch to release the arena, so it has to happen before any write
+    BeginRecording();
+
+    if (size > stagingSize) {
+        source = std::make_shared<VulkanBuffer>(device, instance, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        source->Write(data, size);
+        sourceOffset = 0;
+        oversizedStagingBuffers.push_back(source);
+        return;
+    }
+
+    VkDeviceSize offset = (stagingHead + StagingAlignment - 1) & ~(StagingAlignment - 1);
+    if (offset + size > stagingSize) {
+        // The arena is full, push out the current batch and start over from the beginning
+        Flush();
+        BeginRecording();
+        offset = 0;
+    }
+
+    stagingBuffer->Write(data, size, offset);
+    stagingHead = offset + size;
+
+    source = stagingBuffer;
+    sourceOffset = offset;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "vk_common.h"
+#include "VulkanScheduler.h"
+
+// Records staging copies, layout transitions and mip generation of many resources into a
+// single command buffer, with the barriers of all resources batched together. The source data is packed into a reusable staging arena and the
+// whole batch is submitted once and tracked by a single scheduler ticket.
+//
+// When a transfer command pool from a dedicated transfer family is supplied, the copies run
+// on the transfer queue instead. Ownership of every destination is released there and acquired
+// by a graphics queue submission that waits on the transfer ticket, which also handles mip generation.
+class VulkanUploadContext {
+    VK_NON_COPIABLE(VulkanUploadContext)
+
+public:
+    VulkanUploadContext(std::shared_ptr<VulkanDevice> device_, std::shared_ptr<VulkanInstance> instance_,
+                        std::shared_ptr<VulkanCommandPool> commandPool_, std::shared_ptr<VulkanCommandPool> transferCommandPool_ = nullptr,
+                        VkDeviceSize stagingSize_ = DefaultStagingSize);
+
+    ~VulkanUploadContext();
+
+    void UploadBuffer(std::shared_ptr<VulkanBuffer> destination, const void *data, VkDeviceSize size, VkDeviceSize destinationOffset = 0);
+
+    void UploadImage(std::shared_ptr<VulkanImage> destination, const void *data, VkDeviceSize size);
+
+    // Graphics queue command buffer of the current batch. The uploads of the batch are only
+    // guaranteed to be visible to work submitted after it.
+    std::shared_ptr<VulkanCommandBuffer> GetCommandBuffer();
+
+    bool IsAsync() const;
+
+    bool IsComplete();
+
+    // Ticket of the last submitted batch, other submissions can wait on it instead of calling Wait()
+    VulkanTicket GetTicket() const;
+
+    void Submit();
+
+    void Wait();
+
+    void Flush();
+
+private:
+    void BeginRecording();
+
+    void RecordImageUploads();
+
+    void StageData(const void *data, VkDeviceSize size, std::shared_ptr<VulkanBuffer> &source, VkDeviceSize &sourceOffset);
+
+private:
+    static constexpr VkDeviceSize DefaultStagingSize = 32ull * 1024 * 1024;
+    static constexpr VkDeviceSize StagingAlignment = 16; // Covers the texel size and the 4 byte alignment of buffer to image copies
+
+    std::shared_ptr<VulkanDevice> device;
+    std::shared_ptr<VulkanInstance> instance;
+    std::shared_ptr<VulkanCommandPool> commandPool;
+    std::shared_ptr<VulkanCommandPool> transferCommandPool;
+
+private:
+    std::shared_ptr<VulkanCommandBuffer> commandBuffer;
+    std::shared_ptr<VulkanCommandBuffer> transferCommandBuffer; // Null unless the uploads run on a dedicated transfer queue
+    std::shared_ptr<VulkanBarrierBatcher> barriers;
+    std::shared_ptr<VulkanBarrierBatcher> transferBarriers;
+    VulkanTicket ticket;
+    uint32_t graphicsFamilyIndex = 0;
+    uint32_t transferFamilyIndex = 0;
+    bool isRecording = false;
+    bool isPending = false;
+
+    std::shared_ptr<VulkanBuffer> stagingBuffer;
+    VkDeviceSize stagingSize;
+    VkDeviceSize stagingHead = 0;
+
+    // Uploads that don't fit into the arena get their own staging buffer, kept alive until the batch completes
+    std::vector<std::shared_ptr<VulkanBuffer>> oversizedStagingBuffers;
+
+    struct PendingImageUpload {
+        std::shared_ptr<VulkanImage> image;
+        std::shared_ptr<VulkanBuffer> source;
+        VkDeviceSize sourceOffset;
+    };
+
+    std::vector<PendingImageUpload> pendingImages;
+};
@@ -2,9 +2,15 @@
 
 VulkanWindow *VulkanWindow::instance = nullptr;
 
-VulkanWindow::VulkanWindow() {
+VulkanWindow::VulkanWindow(bool headless_) : headless(headless_) {
     instance = this;
 
+    if (headless)
+        return;
+
+#ifdef VK_HEADLESS_ONLY
+    throw std::runtime_error("built without GLFW, only headless windows are supported!");
+#else
     glfwInit();
 
     glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
@@ -12,12 +18,17 @@ VulkanWindow::VulkanWindow() {
     window = glfwCreateWindow(WIDTH, HEIGHT, "Vulkan", nullptr, nullptr);
     glfwSetWindowUserPointer(window, this);
     glfwSetFramebufferSizeCallback(window, FramebufferResizeCallback);
+#endif
 }
 
 void VulkanWindow::FramebufferResizeCallback(GLFWwindow *, int, int) {
     instance->framebufferResized = true;
 }
 
+bool VulkanWindow::IsHeadless() const {
+    return headless;
+}
+
 bool VulkanWindow::IsWindowResized(bool reset) {
     bool flag = framebufferResized ? true : false;
     if (reset)
@@ -26,24 +37,51 @@ bool VulkanWindow::IsWindowResized(bool reset) {
 }
 
 bool VulkanWindow::IsClosing() const {
-    return glfwWindowShouldClose(window);
+#ifndef VK_HEADLESS_ONLY
+    if (!headless)
+        return closeRequested || glfwWindowShouldClose(window);
+#endif
+    return closeRequested;
+}
+
+void VulkanWindow::Close() {
+    closeRequested = true;
 }
 
 void VulkanWindow::PollEvents() {
-    glfwPollEvents();
+#ifndef VK_HEADLESS_ONLY
+    if (!headless)
+        glfwPollEvents();
+#endif
 }
 
 void VulkanWindow::GetFramebufferSize(int &width, int &height) {
+    // Headless surfaces don't report a current extent, so the swap chain falls back to the fixed size
+    if (headless) {
+        width = static_cast<int>(WIDTH);
+        height = static_cast<int>(HEIGHT);
+        return;
+    }
+
+#ifndef VK_HEADLESS_ONLY
     glfwGetFramebufferSize(window, &width, &height);
+#endif
 }
 
 void VulkanWindow::WaitForEvents() {
-    glfwWaitEvents();
+#ifndef VK_HEADLESS_ONLY
+    if (!headless)
+        glfwWaitEvents();
+#endif
 }
 
 VulkanWindow::~VulkanWindow() {
-    glfwDestroyWindow(window);
-    glfwTerminate();
+#ifndef VK_HEADLESS_ONLY
+    if (!headless) {
+        glfwDestroyWindow(window);
+        glfwTerminate();
+    }
+#endif
 
     window = nullptr;
     instance = nullptr;
@@ -6,11 +6,14 @@ class VulkanWindow {
     VK_NON_COPIABLE(VulkanWindow)
 
 public:
-    VulkanWindow();
+    // A headless window has no native window, presentation goes through VK_EXT_headless_surface instead
+    explicit VulkanWindow(bool headless_ = false);
     ~VulkanWindow();
 
+    bool IsHeadless() const;
     bool IsWindowResized(bool reset);
     bool IsClosing() const;
+    void Close();
     void PollEvents();
     void GetFramebufferSize(int& width, int& height);
     void WaitForEvents();
@@ -22,6 +25,8 @@ private:
     const uint32_t HEIGHT = 600;
 
     bool framebufferResized = false;
+    bool headless = false;
+    bool closeRequested = false;
 
 private:
     static void FramebufferResizeCallback(GLFWwindow *window, int width, int height);
@@ -1,6 +1,8 @@
+#ifndef VK_HEADLESS_ONLY
 #define GLFW_INCLUDE_VULKAN
 
 #include <GLFW/glfw3.h>
+#endif
 
 #include <iostream>
 #include <stdexcept>
@@ -9,6 +11,7 @@
 #include <vector>
 #include <cstdlib>
 #include <cstdint>
+#include <cstddef>
 
 #define STB_IMAGE_IMPLEMENTATION
 #define TINYOBJLOADER_IMPLEMENTATION
@@ -16,7 +19,9 @@
 #include "stb_image.h"
 #include "tiny_obj_loader.h"
 
+#ifndef VK_HEADLESS_ONLY
 #include "vulkan-tutorial/multisampling_29.h"
+#endif
 
 #include "vk_common.h"
 #include "VulkanWindow.h"
@@ -31,11 +36,22 @@
 #include "VulkanImage.h"
 #include "VulkanImageView.h"
 #include "VulkanBuffer.h"
+#include "VulkanRingBuffer.h"
+#include "VulkanUploadContext.h"
+#include "VulkanFrameContext.h"
+#include "VulkanParallelRecorder.h"
+#include "VulkanCommandBufferCache.h"
 #include "VulkanDescriptorSetBuilder.h"
 #include "VulkanDescriptorSet.h"
+#include "VulkanDescriptorUpdateTemplate.h"
+#include "VulkanBindlessTextureTable.h"
 #include "VulkanTextureSampler.h"
 #include "VulkanFramebuffer.h"
 #include "VulkanMesh.h"
+#include "VulkanDeletionQueue.h"
+#include "VulkanRenderGraph.h"
+#include "VulkanPipelineManager.h"
+#include "VulkanShaderCache.h"
 
 #include <immintrin.h>
 #include <xmmintrin.h>
@@ -44,203 +60,346 @@ glm::mat4 quatToMat(glm::vec4 q);
 glm::vec4 angleAxisToQuat(float angle, glm::vec3 axis);
 glm::vec4 lookAt(glm::vec3 eye, glm::vec3 center);
 
+// Settings chosen on the command line
+struct ApplicationOptions {
+    bool headless = false;    // -headless: render a fixed number of frames without a window
+    bool staticScene = false; // -static: reuse pre-recorded command buffers instead of recording the draw list in parallel every frame
+    bool bindless = false;    // -bindless: sample through the bindless texture table with a per-draw index instead of material sets
+
+    // -low-latency and -throughput pick a preset, -present-mode, -images and -frames-in-flight override single values
+    VulkanSwapChainConfig swapChain;
+};
+
+VkPresentModeKHR parsePresentMode(const std::string &name);
+
 class HelloTriangleApplication {
 private:
     const std::string CUBE_MODEL_PATH = "models/cube.obj";
     const std::string ROOM_MODEL_PATH = "models/viking_room.obj";
     const std::string TEXTURE_PATH = "textures/viking_room.png";
+    const std::string PIPELINE_CACHE_PATH = "pipeline_cache.bin";
+
+    // Descriptor set indices, ordered by how often the bound set changes
+    const uint32_t FRAME_SET = 0;    // Camera data, bound once per frame
+    const uint32_t MATERIAL_SET = 1; // Textures, bound when the material changes between draws
+    const VkDeviceSize UNIFORM_RING_FRAME_SIZE = 1024 * 1024;
+    const int MEMORY_STATISTICS_INTERVAL = 10; // seconds
+    const uint32_t RECORDING_THREAD_COUNT = 4;
+    const uint64_t HEADLESS_FRAME_COUNT = 10000; // Benchmark length when rendering without a window
 
 public:
-    void run() {
+    void run(const ApplicationOptions &options_ = ApplicationOptions()) {
+        options = options_;
         initVulkan();
         mainLoop();
     }
 
 private:
+    ApplicationOptions options;
     std::shared_ptr<VulkanWindow> window;
     std::shared_ptr<VulkanInstance> instance;
     std::shared_ptr<VulkanDevice> device;
     std::shared_ptr<VulkanSwapChain> swapChain;
     std::shared_ptr<VulkanRenderPass> renderPass;
+    std::shared_ptr<VulkanPipelineManager> pipelineManager;
+    std::shared_ptr<VulkanShaderCache> shaderCache;
+    std::shared_ptr<VulkanShader> vertexShader;
+    std::shared_ptr<VulkanShader> fragmentShader;
     std::shared_ptr<VulkanGraphicsPipeline> texturedGraphicsPipeline;
     std::shared_ptr<VulkanCommandPool> commandPool;
-    std::shared_ptr<VulkanDescriptorSetBuilder> descriptorSetBuilder;
+    std::shared_ptr<VulkanCommandPool> transferCommandPool;
+    std::shared_ptr<VulkanDescriptorSetBuilder> frameDescriptorSetBuilder;
+    std::shared_ptr<VulkanDescriptorSetBuilder> materialDescriptorSetBuilder;
 
-    std::shared_ptr<VulkanImage> colorImage;
-    std::shared_ptr<VulkanImage> depthImage;
+    std::shared_ptr<VulkanRenderGraph> renderGraph;
+    VulkanRenderGraphResource swapChainResource;
 
     std::shared_ptr<VulkanImage> textureImage;
     std::shared_ptr<VulkanTextureSampler> textureSampler;
 
     std::shared_ptr<VulkanMesh> roomMesh;
     std::shared_ptr<VulkanMesh> cubeMesh;
-
-    std::vector<std::shared_ptr<VulkanFramebuffer>> swapChainFramebuffers;
-    std::vector<std::shared_ptr<VulkanBuffer>> uniformBuffers;
-    std::vector<std::shared_ptr<VulkanDescriptorSet>> descriptorSets;
-    std::vector<std::shared_ptr<VulkanCommandBuffer>> commandBuffers;
+    std::vector<std::shared_ptr<VulkanMesh>> drawList;
+    std::vector<glm::mat4> drawTransforms; // Model matrix of every draw list entry, pushed with the draw
+    std::vector<std::shared_ptr<VulkanDescriptorSet>> drawMaterials; // Material set of every draw list entry
+    std::vector<uint32_t> drawTextureIndices; // Bindless table index of every draw list entry
+
+    std::shared_ptr<VulkanRingBuffer> uniformRing;
+    std::shared_ptr<VulkanDescriptorSet> frameDescriptorSet;
+    std::shared_ptr<VulkanDescriptorSet> textureMaterial;
+    std::shared_ptr<VulkanBindlessTextureTable> bindlessTextures;
+    std::vector<std::shared_ptr<VulkanFrameContext>> frameContexts;
+    std::shared_ptr<VulkanParallelRecorder> parallelRecorder;
+    std::shared_ptr<VulkanCommandBufferCache> staticCommandBuffers;
+
+    // Per-frame state read by the render graph passes while they are recorded
+    std::shared_ptr<VulkanFrameContext> recordingFrameContext;
+    uint32_t recordingUniformOffset = 0;
 
     void initVulkan() { // TODO
-        window = std::make_shared<VulkanWindow>();
+        window = std::make_shared<VulkanWindow>(options.headless);
         instance = std::make_shared<VulkanInstance>(window);
 
-        device = std::make_shared<VulkanDevice>(instance);
+        device = std::make_shared<VulkanDevice>(instance, PIPELINE_CACHE_PATH);
+        if (options.bindless && !device->IsBindlessSupported()) {
+            throw std::runtime_error("bindless textures requested, but not supported!");
+        }
+
         commandPool = std::make_shared<VulkanCommandPool>(QueueFamily::Graphics, device, instance);
+        transferCommandPool = std::make_shared<VulkanCommandPool>(QueueFamily::Transfer, device, instance);
         textureSampler = std::make_shared<VulkanTextureSampler>(instance, device);
+        pipelineManager = std::make_shared<VulkanPipelineManager>(device);
+        shaderCache = std::make_shared<VulkanShaderCache>(device);
+
+        vertexShader = shaderCache->Load("shaders/vert.spv");
+        fragmentShader = shaderCache->Load(options.bindless ? "shaders/frag_bindless.spv" : "shaders/frag.spv");
 
         loadResources();
         createUniformBuffers();
 
-        descriptorSetBuilder = std::make_shared<VulkanDescriptorSetBuilder>(device, swapChain->GetImageCount());
-        descriptorSetBuilder->AddLayoutSlot(ShaderStage::Vertex, 0, ShaderResourceType::UniformBuffer, 1);
-        descriptorSetBuilder->AddLayoutSlot(ShaderStage::Fragment, 1, ShaderResourceType::ImageSampler, 1);
-        descriptorSets = descriptorSetBuilder->Build();
-        for (int i = 0; i < swapChain->GetImageCount(); i++) {
-            descriptorSets[i]->WriteUniformBuffer(0, uniformBuffers[i], sizeof(UniformBufferObject));
-            descriptorSets[i]->WriteImage(1, textureSampler, textureImage->GetView(VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT));
+        // A single frame set is enough, the per-frame uniform data is selected with a dynamic offset
+        frameDescriptorSetBuilder = std::make_shared<VulkanDescriptorSetBuilder>(device, 1);
+        frameDescriptorSetBuilder->AddReflectedSlots({vertexShader, fragmentShader}, FRAME_SET);
+        frameDescriptorSetBuilder->SetSlotType(0, ShaderResourceType::UniformBufferDynamic);
+        frameDescriptorSet = frameDescriptorSetBuilder->Build()[0];
+
+        auto frameTemplate = frameDescriptorSetBuilder->CreateUpdateTemplate();
+        frameTemplate->SetBuffer(0, uniformRing->GetBuffer(), 0, sizeof(UniformBufferObject));
+        frameTemplate->Update(frameDescriptorSet);
+
+        if (options.bindless) {
+            // The table takes the material set index and is bound once, every draw selects its texture with a push constant
+            bindlessTextures = std::make_shared<VulkanBindlessTextureTable>(device);
+            uint32_t textureIndex = bindlessTextures->Register(textureSampler, textureImage->GetView(VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT));
+            bindlessTextures->Flush();
+
+            drawTextureIndices.assign(drawList.size(), textureIndex);
+        } else {
+            // One set per material, the template writes all bindings of a material in one call
+            materialDescriptorSetBuilder = std::make_shared<VulkanDescriptorSetBuilder>(device, 1);
+            materialDescriptorSetBuilder->AddReflectedSlots({vertexShader, fragmentShader}, MATERIAL_SET);
+            textureMaterial = materialDescriptorSetBuilder->Build()[0];
+
+            auto materialTemplate = materialDescriptorSetBuilder->CreateUpdateTemplate();
+            materialTemplate->SetImage(0, textureSampler, textureImage->GetView(VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT));
+            materialTemplate->Update(textureMaterial);
+
+            drawMaterials.assign(drawList.size(), textureMaterial);
         }
 
+        createRenderGraph();
         createGraphicsPipeline();
-        createFramebufferResources();
-        createFramebuffers();
 
-        createCommandBuffers();
+        createFrameContexts();
+        staticCommandBuffers = std::make_shared<VulkanCommandBufferCache>(commandPool);
     }
 
     void recreateSwapChain() {
-        swapChain = std::make_shared<VulkanSwapChain>(window, device, instance);
-        renderPass = std::make_shared<VulkanRenderPass>(instance, device, swapChain);
+        // The old swap chain and everything built on it is released through the deletion queue once its frames are done
+        swapChain = std::make_shared<VulkanSwapChain>(window, device, instance, swapChain, options.swapChain);
 
-        createGraphicsPipeline();
-        createFramebufferResources();
-        createFramebuffers();
-        createCommandBuffers();
+        createRenderGraph();
+
+        // Viewport and scissor are dynamic, so the pipeline only has to be rebuilt when the attachment formats change
+        if (!texturedGraphicsPipeline->GetRenderPass()->IsCompatibleWith(*renderPass)) {
+            createGraphicsPipeline();
+
+            // Variants of the replaced render pass can't be used anymore
+            pipelineManager->Evict([this](const VulkanGraphicsPipelineState &state) {
+                return !state.renderPass->IsCompatibleWith(*renderPass);
+            });
+        }
+
+        // The cached command buffers reference the old framebuffers
+        staticCommandBuffers->Invalidate();
     }
 
     void createGraphicsPipeline() {
-        texturedGraphicsPipeline = std::make_shared<VulkanGraphicsPipeline>(
-            std::make_shared<VulkanShader>("shaders/vert.spv", device),
-            std::make_shared<VulkanShader>("shaders/frag.spv", device),
-            renderPass, device, swapChain, descriptorSetBuilder->GetLayout());
+        VulkanGraphicsPipelineState state;
+        state.vertexShader = vertexShader;
+        state.fragmentShader = fragmentShader;
+        state.renderPass = renderPass;
+        state.descriptorSetLayouts = {frameDescriptorSetBuilder->GetLayoutDescription(),
+                                      bindlessTextures != nullptr ? bindlessTextures->GetLayoutDescription() : materialDescriptorSetBuilder->GetLayoutDescription()};
+
+        // Nothing can be drawn without it, so wait for this variant instead of using TryGet
+        texturedGraphicsPipeline = pipelineManager->Request(state).get();
     }
 
     void loadResources() {
-        textureImage = VulkanImage::LoadFrom(TEXTURE_PATH.c_str(), instance, device, commandPool);
+        // Every upload below is recorded into one batch and submitted together, on the transfer queue if the device has one
+        auto uploadContext = std::make_shared<VulkanUploadContext>(device, instance, commandPool, transferCommandPool);
+
+        textureImage = VulkanImage::LoadFrom(TEXTURE_PATH.c_str(), instance, device, uploadContext);
 
         roomMesh = std::make_shared<VulkanMesh>(ROOM_MODEL_PATH.c_str());
-        roomMesh->CreateBuffers(commandPool, instance, device);
+        roomMesh->CreateBuffers(uploadContext, instance, device);
 
         cubeMesh = std::make_shared<VulkanMesh>(CUBE_MODEL_PATH.c_str());
-        cubeMesh->CreateBuffers(commandPool, instance, device);
+        cubeMesh->CreateBuffers(uploadContext, instance, device);
+
+        drawList = {roomMesh};
+        drawTransforms = {glm::identity<glm::mat4>()};
 
-        swapChain = std::make_shared<VulkanSwapChain>(window, device, instance);
-        renderPass = std::make_shared<VulkanRenderPass>(instance, device, swapChain);
+        uploadContext->Flush();
+
+        swapChain = std::make_shared<VulkanSwapChain>(window, device, instance, nullptr, options.swapChain);
     }
 
     void mainLoop() {
         uint64_t sampleCount = 0;
         auto lastPrint = std::chrono::high_resolution_clock::now();
+        auto lastMemoryPrint = lastPrint;
+        uint64_t frameCount = 0;
         while (!window->IsClosing()) {
             window->PollEvents();
             auto t1 = std::chrono::high_resolution_clock::now();
             drawFrame();
             sampleCount++;
 
+            if (options.headless && ++frameCount >= HEADLESS_FRAME_COUNT)
+                window->Close();
+
             if (std::chrono::duration_cast<std::chrono::milliseconds>(t1 - lastPrint).count() > 1000) {
                 printf("Avg. FPS = %lld\n", sampleCount);
                 sampleCount = 0;
                 lastPrint = t1;
             }
+
+            if (std::chrono::duration_cast<std::chrono::seconds>(t1 - lastMemoryPrint).count() >= MEMORY_STATISTICS_INTERVAL) {
+                device->GetMemoryAllocator()->PrintStatistics();
+                lastMemoryPrint = t1;
+            }
         }
 
         device->WaitIdle();
     }
 
-    void createFramebuffers() {
-        swapChainFramebuffers.clear();
+    void createRenderGraph() {
+        renderGraph = std::make_shared<VulkanRenderGraph>(instance, device);
 
-        for (size_t i = 0; i < swapChain->GetImageCount(); i++) {
-            std::vector<std::shared_ptr<VulkanImageView>> attachments = {
-                colorImage->GetView(swapChain->GetFormat(), VK_IMAGE_ASPECT_COLOR_BIT),
-                depthImage->GetView(renderPass->FindDepthFormat(), VK_IMAGE_ASPECT_DEPTH_BIT),
-                swapChain->GetImageView(i)
-            };
-            swapChainFramebuffers.push_back(std::make_shared<VulkanFramebuffer>(device, swapChain, renderPass, attachments));
-        }
-    }
+        // The multisampled targets only live inside the main pass, the graph creates and aliases them
+        auto colorResource = renderGraph->CreateImage("color", swapChain->GetExtent(), swapChain->GetFormat(), VulkanInstance::MsaaSamples);
+        auto depthResource = renderGraph->CreateImage("depth", swapChain->GetExtent(), instance->FindDepthFormat(), VulkanInstance::MsaaSamples);
+
+        // Acquisition is waited on in the color attachment output stage, the transition into the pass has to come after it
+        swapChainResource = renderGraph->ImportImage("swapchain", swapChain->GetExtent(), swapChain->GetFormat(),
+                                                     VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+                                                     VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
 
-    void createFramebufferResources() {
-        colorImage = std::make_shared<VulkanImage>(instance, device, swapChain->GetExtent().width, swapChain->GetExtent().height, VulkanInstance::MsaaSamples,
-                                                   swapChain->GetFormat(), VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
-                                                   VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false);
-        depthImage = std::make_shared<VulkanImage>(instance, device, swapChain->GetExtent().width, swapChain->GetExtent().height, VulkanInstance::MsaaSamples,
-                                                   renderPass->FindDepthFormat(), VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
-                                                   VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false);
+        auto &mainPass = renderGraph->AddPass("main", [this](const VulkanRenderGraphContext &context) {
+            if (options.staticScene) {
+                // Recorded inline, secondary command buffers of the frame contexts don't outlive a single frame
+                recordDrawList(context.commandBuffer, 0, drawList.size(), recordingUniformOffset, context.framebuffer->GetExtent());
+                return;
+            }
+
+            // The draw list is split across the worker threads, each one records a secondary command buffer
+            context.commandBuffer->ExecuteCommands(parallelRecorder->RecordSecondary(
+                recordingFrameContext, context.renderPass, context.framebuffer, drawList.size(),
+                [&](std::shared_ptr<VulkanCommandBuffer> secondaryCommandBuffer, size_t begin, size_t end) {
+                    recordDrawList(secondaryCommandBuffer, begin, end, recordingUniformOffset, context.framebuffer->GetExtent());
+                }));
+        });
+        mainPass.AddColorOutput(colorResource, VkClearColorValue{{0.0f, 0.0f, 0.0f, 1.0f}})
+                .SetDepthOutput(depthResource, VkClearDepthStencilValue{1.0f, 0})
+                .AddResolveOutput(swapChainResource)
+                .SetContents(options.staticScene ? VK_SUBPASS_CONTENTS_INLINE : VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+        renderGraph->Compile();
+        renderPass = mainPass.GetRenderPass();
     }
 
     void createUniformBuffers() {
-        VkDeviceSize bufferSize = sizeof(UniformBufferObject);
-        uniformBuffers.resize(swapChain->GetImageCount());
-
-        for (size_t i = 0; i < swapChain->GetImageCount(); i++) {
-            uniformBuffers[i] = std::make_shared<VulkanBuffer>(device, instance, bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-                                                               VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-        }
+        uniformRing = std::make_shared<VulkanRingBuffer>(device, instance, UNIFORM_RING_FRAME_SIZE, swapChain->GetMaxFramesInFlight());
     }
 
-    void createCommandBuffers() {
-        commandBuffers.clear();
-        for (int i = 0; i < swapChainFramebuffers.size(); i++)
-            commandBuffers.push_back(commandPool->AllocateBuffer());
+    void createFrameContexts() {
+        parallelRecorder = std::make_shared<VulkanParallelRecorder>(RECORDING_THREAD_COUNT);
+
+        frameContexts.clear();
+        for (int i = 0; i < swapChain->GetMaxFramesInFlight(); i++)
+            frameContexts.push_back(std::make_shared<VulkanFrameContext>(device, instance, parallelRecorder->GetThreadCount()));
     }
 
-    void updateUniformBuffer(uint32_t currentImage) {
+    uint32_t updateUniformBuffer() {
         static auto startTime = std::chrono::high_resolution_clock::now();
 
         auto currentTime = std::chrono::high_resolution_clock::now();
         float time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count() * 0.1f;
 
         UniformBufferObject ubo{};
-        ubo.model = glm::rotate(glm::identity<glm::mat4>(), time * glm::radians(90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-        ubo.view = glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        // The scene spin lives in the view matrix, the pushed model matrices are baked into the cached command buffers
+        ubo.model = glm::identity<glm::mat4>();
+        ubo.view = glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f)) *
+                   glm::rotate(glm::identity<glm::mat4>(), time * glm::radians(90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
         //ubo.view = glm::translate(quatToMat(lookAt(glm::vec3(2.0f, 2.0f, 2.0f), glm::vec3(0.0f, 0.0f, 0.0f))) ,glm::vec3(2.0f, 2.0f, 2.0f));
         ubo.proj = glm::perspective(glm::radians(45.0f), swapChain->GetExtent().width / (float) swapChain->GetExtent().height, 0.1f, 10.0f);
         ubo.proj[1][1] *= -1;
 
-        glm::inverse(ubo.model);
-
-        uniformBuffers[currentImage]->CopyFrom(&ubo, sizeof(ubo));
+        return uniformRing->Push(ubo);
     }
 
-    void recordCommandBuffers(uint32_t imageIndex) {
-        // commandBuffers[imageIndex]->Reset();
-        commandBuffers[imageIndex]->Begin(false);
-        {
-            renderPass->Begin(commandBuffers[imageIndex], swapChainFramebuffers[imageIndex]);
-            {
-                // Bind the Shader configuration (aka Pipeline)
-                texturedGraphicsPipeline->Bind(commandBuffers[imageIndex]);
-
-                // Bind the shader descriptor set (aka which resources belong to which shader layout slots)
-                descriptorSets[0]->Bind(commandBuffers[imageIndex], texturedGraphicsPipeline);
-
-                // Bind the VulkanMesh
-                roomMesh->Bind(commandBuffers[imageIndex]);
-                // Main Draw command
-                roomMesh->Draw(commandBuffers[imageIndex]);
-            }
-            renderPass->End(commandBuffers[imageIndex]);
+    void recordDrawList(std::shared_ptr<VulkanCommandBuffer> commandBuffer, size_t begin, size_t end, uint32_t uniformOffset, VkExtent2D extent) {
+        // Bind the Shader configuration (aka Pipeline)
+        texturedGraphicsPipeline->Bind(commandBuffer);
+        commandBuffer->SetViewportAndScissor(extent);
+
+        // Bind the shader descriptor sets (aka which resources belong to which shader layout slots)
+        frameDescriptorSet->Bind(commandBuffer, texturedGraphicsPipeline, {uniformOffset}, FRAME_SET);
+        if (bindlessTextures != nullptr)
+            bindlessTextures->Bind(commandBuffer, texturedGraphicsPipeline, MATERIAL_SET);
+
+        for (size_t i = begin; i < end; i++) {
+            // Only issues a bind when the material differs from the previous draw
+            if (bindlessTextures == nullptr)
+                drawMaterials[i]->Bind(commandBuffer, texturedGraphicsPipeline, {}, MATERIAL_SET);
+            // Bind the VulkanMesh
+            drawList[i]->Bind(commandBuffer);
+            // Per-object data goes inline instead of through the uniform buffer
+            commandBuffer->PushConstants(texturedGraphicsPipeline, drawTransforms[i], offsetof(DrawPushConstants, model));
+            if (bindlessTextures != nullptr)
+                commandBuffer->PushConstants(texturedGraphicsPipeline, drawTextureIndices[i], offsetof(DrawPushConstants, textureIndex));
+            // Main Draw command
+            drawList[i]->Draw(commandBuffer);
         }
-        commandBuffers[imageIndex]->End();
+    }
+
+    void recordRenderGraph(std::shared_ptr<VulkanCommandBuffer> commandBuffer, std::shared_ptr<VulkanFrameContext> frameContext,
+                           uint32_t imageIndex, uint32_t uniformOffset) {
+        recordingFrameContext = frameContext;
+        recordingUniformOffset = uniformOffset;
+
+        renderGraph->SetImportedImage(swapChainResource, swapChain->GetImageView(imageIndex));
+        renderGraph->Execute(commandBuffer);
     }
 
     void drawFrame() {
         swapChain->WaitForLastSubmit();
+        device->GetDeletionQueue()->Collect();
         int imageIndex = swapChain->AcquireNextImage();
-        commandBuffers[imageIndex]->Reset();
 
-        updateUniformBuffer(imageIndex);
-        recordCommandBuffers(imageIndex);
+        // The ticket wait above guarantees the GPU is done with this frame's command buffers and uniform partition
+        auto frameContext = frameContexts[swapChain->GetCurrentFrame()];
+        frameContext->Begin();
+
+        uniformRing->BeginFrame(swapChain->GetCurrentFrame());
+        uint32_t uniformOffset = updateUniformBuffer();
+        uniformRing->Flush();
+
+        std::shared_ptr<VulkanCommandBuffer> commandBuffer;
+        if (options.staticScene) {
+            // Per-frame data only changes buffer contents, the recorded commands stay the same
+            commandBuffer = staticCommandBuffers->GetOrRecord(swapChain->GetCurrentFrame(), imageIndex, uniformOffset,
+                                                              [&](std::shared_ptr<VulkanCommandBuffer> staticCommandBuffer) {
+                recordRenderGraph(staticCommandBuffer, frameContext, imageIndex, uniformOffset);
+            });
+        } else {
+            commandBuffer = frameContext->AllocateCommandBuffer();
+            commandBuffer->Begin(true);
+            recordRenderGraph(commandBuffer, frameContext, imageIndex, uniformOffset);
+            commandBuffer->End();
+        }
 
         if (swapChain->IsInvalid() || window->IsWindowResized(true)) {
             recreateSwapChain();
@@ -248,7 +407,7 @@ private:
         }
 
         // Submit
-        swapChain->SubmitCommands(commandBuffers[imageIndex]);
+        swapChain->SubmitCommands(commandBuffer);
 
         // Present
         swapChain->Present();
@@ -308,21 +467,77 @@ glm::vec4 lookAt(glm::vec3 eye, glm::vec3 center) {
     return angleAxisToQuat(angle, axis);
 }
 
+VkPresentModeKHR parsePresentMode(const std::string &name) {
+    if (name == "immediate")
+        return VK_PRESENT_MODE_IMMEDIATE_KHR;
+    if (name == "mailbox")
+        return VK_PRESENT_MODE_MAILBOX_KHR;
+    if (name == "fifo")
+        return VK_PRESENT_MODE_FIFO_KHR;
+    if (name == "fifo-relaxed")
+        return VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+
+    throw std::invalid_argument("unknown present mode " + name + "!");
+}
+
 int main(int argc, char **argv) {
 
     auto m1 = glm::lookAt(glm::vec3(1.0f, 2.0f, 3.0f), glm::vec3(4.0f, 5.0f, 6.0f), glm::vec3(0.0f, 1.0f, 0.0f));
     printMatrix(m1);
 
-    bool runApp29 = argc >= 2 && strcmp(argv[1], "-app29") == 0;
+    bool runApp29 = false;
+    ApplicationOptions options;
 
+#ifndef VK_HEADLESS_ONLY
     VulkanTutorial::multisampling_29 app29;
+#endif
     HelloTriangleApplication app;
 
     try {
+        for (int i = 1; i < argc; i++) {
+            // Options that take a value consume the next argument
+            auto value = [&]() -> const char * {
+                if (i + 1 >= argc) {
+                    throw std::invalid_argument(std::string("missing value for ") + argv[i] + "!");
+                }
+                return argv[++i];
+            };
+
+            if (strcmp(argv[i], "-app29") == 0)
+                runApp29 = true;
+            else if (strcmp(argv[i], "-headless") == 0)
+                options.headless = true;
+            else if (strcmp(argv[i], "-static") == 0)
+                options.staticScene = true;
+            else if (strcmp(argv[i], "-bindless") == 0)
+                options.bindless = true;
+            else if (strcmp(argv[i], "-low-latency") == 0)
+                options.swapChain = VulkanSwapChainConfig::LowLatency();
+            else if (strcmp(argv[i], "-throughput") == 0)
+                options.swapChain = VulkanSwapChainConfig::Throughput();
+            else if (strcmp(argv[i], "-present-mode") == 0)
+                options.swapChain.presentModes = {parsePresentMode(value())}; // FIFO stays the fallback
+            else if (strcmp(argv[i], "-images") == 0)
+                options.swapChain.imageCount = static_cast<uint32_t>(std::stoul(value()));
+            else if (strcmp(argv[i], "-frames-in-flight") == 0)
+                options.swapChain.maxFramesInFlight = std::stoi(value());
+            else
+                throw std::invalid_argument(std::string("unknown argument ") + argv[i] + "!");
+        }
+
+#ifdef VK_HEADLESS_ONLY
+        // Built without GLFW, there is no window to render into
+        if (runApp29) {
+            throw std::runtime_error("the tutorial sample needs a build with GLFW!");
+        }
+        options.headless = true;
+        app.run(options);
+#else
         if (runApp29)
             app29.run();
         else
-            app.run();
+            app.run(options);
+#endif
     } catch (const std::exception &e) {
         std::cerr << e.what() << std::endl;
         return EXIT_FAILURE;
@@ -1,8 +1,14 @@
 #pragma once
 
+#ifdef _WIN32
 #define VK_USE_PLATFORM_WIN32_KHR
+#endif
 #include <vulkan/vulkan.h>
+#ifdef VK_HEADLESS_ONLY
+struct GLFWwindow; // Built without GLFW, only headless windows can be created
+#else
 #include <GLFW/glfw3.h>
+#endif
 #include <stdexcept>
 #include <vector>
 #include <memory>
@@ -7,14 +7,34 @@ class VulkanSwapChain;
 class VulkanFramebuffer;
 class VulkanRenderPass;
 class VulkanShader;
+class VulkanShaderCache;
 class VulkanGraphicsPipeline;
 class VulkanCommandPool;
 class VulkanCommandBuffer;
 class VulkanImage;
 class VulkanImageView;
 class VulkanBuffer;
+class VulkanRingBuffer;
+class VulkanUploadContext;
+class VulkanFrameContext;
+class VulkanParallelRecorder;
+class VulkanCommandBufferCache;
 class VulkanDescriptorSet;
+class VulkanDescriptorAllocator;
+class VulkanDescriptorWriter;
+class VulkanDescriptorUpdateTemplate;
+class VulkanBindlessTextureTable;
 class VulkanTextureSampler;
+class VulkanMemoryAllocator;
+class VulkanScheduler;
+class VulkanDeletionQueue;
+class VulkanRenderGraph;
+class VulkanRenderGraphPass;
+class VulkanBarrierBatcher;
+class VulkanPipelineCache;
+class VulkanPipelineManager;
+struct VulkanTicket;
+struct VulkanDescriptorSetLayoutDescription;
 
 class VulkanMesh;
 class VkValidationClient;
\ No newline at end of file
@@ -13,6 +13,10 @@ struct QueueFamilyIndices {
     std::optional<uint32_t> graphicsFamily;
     std::optional<uint32_t> presentFamily;
 
+    // Only set when the device exposes a family without graphics support for them
+    std::optional<uint32_t> computeFamily;
+    std::optional<uint32_t> transferFamily;
+
     bool isComplete() {
         return graphicsFamily.has_value() && presentFamily.has_value();
     }
@@ -87,8 +91,14 @@ enum class ShaderStage {
     Compute = VK_SHADER_STAGE_COMPUTE_BIT,
 };
 
+// The model matrix is pushed per draw with DrawPushConstants, the member only keeps the shader block layout
 struct UniformBufferObject {
     alignas(16) glm::mat4 model;
     alignas(16) glm::mat4 view;
     alignas(16) glm::mat4 proj;
 };
+
+struct DrawPushConstants {
+    alignas(16) glm::mat4 model;
+    uint32_t textureIndex; // Only declared by the bindless fragment shader, so it is pushed on its own
+};